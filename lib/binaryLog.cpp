@@ -0,0 +1,205 @@
+#ifndef BINARYLOG_CPP
+#define BINARYLOG_CPP
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+#include <vector>
+#include <map>
+#include "side.hpp"
+#include "orderBook.hpp"
+#include "mappedFile.hpp"
+#include "span.hpp"
+#include "binaryLog.hpp"
+using namespace std;
+
+/**** helper functions ********************************************************/
+
+static size_t alignColumn(size_t offset) {
+    return (offset+7)/8*8;
+}
+
+template <typename T>
+static void writeColumn(ofstream& f, const vector<T>& column) {
+    static const char pad[8] = {};
+    size_t n = column.size()*sizeof(T);
+    f.write(reinterpret_cast<const char*>(column.data()), n);
+    f.write(pad, alignColumn(n)-n);
+}
+
+template <typename T>
+static bool readColumn(const MappedFile& file, size_t& offset, size_t n, Span<T>& column) {
+    // n comes from the header, so it is checked without overflowing
+    if (offset > file.getSize() || n > (file.getSize()-offset)/sizeof(T)) return false;
+    column = Span<T>(reinterpret_cast<const T*>(file.getData()+offset), n);
+    offset = alignColumn(offset+n*sizeof(T));
+    return true;
+}
+
+static const BinaryLogHeader* readHeader(const MappedFile& file, const char* magic, int version) {
+    if (!file.isOpen() || file.getSize() < sizeof(BinaryLogHeader)) return 0;
+    const BinaryLogHeader* header = reinterpret_cast<const BinaryLogHeader*>(file.getData());
+    if (memcmp(header->magic, magic, 8) || header->version != version) return 0;
+    if (header->numRows < 0 || header->numLevels < 0) return 0;
+    return header;
+}
+
+/**** class functions *********************************************************/
+//### DepthLogFile class #######################################################
+
+DepthLogFile::DepthLogFile(string filename): header(0) {
+    open(filename);
+}
+
+map<double,int> DepthLogFile::getBidDepths(long long snap) const {
+    map<double,int> depths;
+    Span<double> p = getBidPrices(snap);
+    Span<int> s = getBidSizes(snap);
+    for (size_t i=0; i<p.size() && s[i]; i++) depths[p[i]] = s[i];
+    return depths;
+}
+
+map<double,int> DepthLogFile::getAskDepths(long long snap) const {
+    map<double,int> depths;
+    Span<double> p = getAskPrices(snap);
+    Span<int> s = getAskSizes(snap);
+    for (size_t i=0; i<p.size() && s[i]; i++) depths[p[i]] = s[i];
+    return depths;
+}
+
+bool DepthLogFile::open(string filename) {
+    close();
+    file.open(filename);
+    header = readHeader(file, "OBSDEPTH", VERSION);
+    if (!header) {close(); return false;}
+    size_t n = header->numRows, m = n*header->numLevels;
+    size_t offset = sizeof(BinaryLogHeader);
+    if ((header->numLevels && m/header->numLevels != n) || !readColumn(file, offset, n, times) ||
+        !readColumn(file, offset, m, bidPrices) || !readColumn(file, offset, m, bidSizes) ||
+        !readColumn(file, offset, m, askPrices) || !readColumn(file, offset, m, askSizes)) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void DepthLogFile::close() {
+    file.close();
+    header = 0;
+    times = Span<int>();
+    bidPrices = askPrices = Span<double>();
+    bidSizes = askSizes = Span<int>();
+}
+
+bool DepthLogFile::write(string filename, const map<int,map<double,int>>& bidDepthsLog, const map<int,map<double,int>>& askDepthsLog, int numLevels, int snapInterval) {
+    // snapshot times are those of the bid log, numLevels=0 keeps every level
+    if (!numLevels) {
+        for (auto& b : bidDepthsLog) numLevels = max(numLevels, (int)b.second.size());
+        for (auto& a : askDepthsLog) numLevels = max(numLevels, (int)a.second.size());
+    }
+    size_t n = bidDepthsLog.size();
+    BinaryLogHeader header = {};
+    memcpy(header.magic, "OBSDEPTH", 8);
+    header.version = VERSION;
+    header.numLevels = numLevels;
+    header.snapInterval = snapInterval;
+    header.numRows = n;
+    ofstream f(filename, ios::binary);
+    if (!f) return false;
+    f.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    vector<int> times;
+    times.reserve(n);
+    for (auto& b : bidDepthsLog) times.push_back(b.first);
+    writeColumn(f, times);
+    for (Side side : {BID, ASK}) {
+        // one side at a time, so only two columns are held in memory
+        vector<double> prices(n*numLevels, 0);
+        vector<int> sizes(n*numLevels, 0);
+        const map<int,map<double,int>>* log = (side==BID)?&bidDepthsLog:&askDepthsLog;
+        for (size_t s=0; s<n; s++) {
+            auto depths = log->find(times[s]);
+            if (depths == log->end()) continue;
+            size_t k = s*numLevels;
+            if (side == BID)
+                for (auto i=depths->second.rbegin(); i!=depths->second.rend() && k<(s+1)*numLevels; i++, k++) {
+                    prices[k] = i->first;
+                    sizes[k] = i->second;
+                }
+            else
+                for (auto i=depths->second.begin(); i!=depths->second.end() && k<(s+1)*numLevels; i++, k++) {
+                    prices[k] = i->first;
+                    sizes[k] = i->second;
+                }
+        }
+        writeColumn(f, prices);
+        writeColumn(f, sizes);
+    }
+    return f.good();
+}
+
+//### TradeLogFile class #######################################################
+
+TradeLogFile::TradeLogFile(string filename): header(0) {
+    open(filename);
+}
+
+Trade TradeLogFile::getTrade(long long i) const {
+    return Trade(times[i], (directions[i]==1)?BID:ASK, sizes[i], prices[i], ids[i], matchIds[i]);
+}
+
+vector<Trade> TradeLogFile::getTrades() const {
+    vector<Trade> trades;
+    trades.reserve(getNumTrades());
+    for (long long i=0; i<getNumTrades(); i++) trades.push_back(getTrade(i));
+    return trades;
+}
+
+bool TradeLogFile::open(string filename) {
+    close();
+    file.open(filename);
+    header = readHeader(file, "OBSTRADE", VERSION);
+    if (!header) {close(); return false;}
+    size_t n = header->numRows;
+    size_t offset = sizeof(BinaryLogHeader);
+    if (!readColumn(file, offset, n, times) || !readColumn(file, offset, n, ids) ||
+        !readColumn(file, offset, n, matchIds) || !readColumn(file, offset, n, sizes) ||
+        !readColumn(file, offset, n, prices) || !readColumn(file, offset, n, directions)) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void TradeLogFile::close() {
+    file.close();
+    header = 0;
+    times = ids = matchIds = sizes = directions = Span<int>();
+    prices = Span<double>();
+}
+
+bool TradeLogFile::write(string filename, const vector<Trade>& trades) {
+    size_t n = trades.size();
+    BinaryLogHeader header = {};
+    memcpy(header.magic, "OBSTRADE", 8);
+    header.version = VERSION;
+    header.numRows = n;
+    ofstream f(filename, ios::binary);
+    if (!f) return false;
+    f.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    vector<int> column(n);
+    for (size_t i=0; i<n; i++) column[i] = trades[i].getTime();
+    writeColumn(f, column);
+    for (size_t i=0; i<n; i++) column[i] = trades[i].getBookId();
+    writeColumn(f, column);
+    for (size_t i=0; i<n; i++) column[i] = trades[i].getMatchId();
+    writeColumn(f, column);
+    for (size_t i=0; i<n; i++) column[i] = trades[i].getSize();
+    writeColumn(f, column);
+    vector<double> prices(n);
+    for (size_t i=0; i<n; i++) prices[i] = trades[i].getPrice();
+    writeColumn(f, prices);
+    for (size_t i=0; i<n; i++) column[i] = (trades[i].getSide()==BID)?1:-1;
+    writeColumn(f, column);
+    return f.good();
+}
+
+#endif
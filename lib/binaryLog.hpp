@@ -0,0 +1,101 @@
+#ifndef BINARYLOG_HPP
+#define BINARYLOG_HPP
+#include <string>
+#include <vector>
+#include <map>
+#include "side.hpp"
+#include "orderBook.hpp"
+#include "mappedFile.hpp"
+#include "span.hpp"
+using namespace std;
+
+/**** class declarations ******************************************************/
+
+struct BinaryLogHeader {
+    // 32-byte header of the binary logs, followed by fixed-width columns of
+    // numRows values each, every column starting on an 8-byte boundary
+    char magic[8]; // "OBSDEPTH" or "OBSTRADE"
+    int version;
+    int numLevels; // levels per side of a depth snapshot, 0 for trades
+    int snapInterval; // 0 for trades
+    int reserved;
+    long long numRows; // snapshots or trades
+};
+
+class DepthLogFile {
+    // columnar depth snapshots: times, then bid prices, bid sizes, ask prices
+    // and ask sizes with numLevels values per snapshot from the best level
+    // out, unused levels are zero; columns are read in place from the map
+private:
+    MappedFile file;
+    const BinaryLogHeader* header;
+    Span<int> times;
+    Span<double> bidPrices, askPrices;
+    Span<int> bidSizes, askSizes;
+public:
+    static const int VERSION = 1;
+    /**** constructors ****/
+    DepthLogFile(): header(0) {}
+    DepthLogFile(string filename);
+    DepthLogFile(const DepthLogFile&) = delete;
+    DepthLogFile& operator=(const DepthLogFile&) = delete;
+    /**** accessors ****/
+    bool isOpen() const {return header!=0;}
+    string getFilename() const {return file.getFilename();}
+    long long getNumSnaps() const {return (header)?header->numRows:0;}
+    int getNumLevels() const {return (header)?header->numLevels:0;}
+    int getSnapInterval() const {return (header)?header->snapInterval:0;}
+    Span<int> getTimes() const {return times;}
+    Span<double> getBidPrices() const {return bidPrices;}
+    Span<int> getBidSizes() const {return bidSizes;}
+    Span<double> getAskPrices() const {return askPrices;}
+    Span<int> getAskSizes() const {return askSizes;}
+    Span<double> getBidPrices(long long snap) const {return bidPrices.subspan(snap*getNumLevels(), getNumLevels());}
+    Span<int> getBidSizes(long long snap) const {return bidSizes.subspan(snap*getNumLevels(), getNumLevels());}
+    Span<double> getAskPrices(long long snap) const {return askPrices.subspan(snap*getNumLevels(), getNumLevels());}
+    Span<int> getAskSizes(long long snap) const {return askSizes.subspan(snap*getNumLevels(), getNumLevels());}
+    map<double,int> getBidDepths(long long snap) const;
+    map<double,int> getAskDepths(long long snap) const;
+    /**** main ****/
+    bool open(string filename);
+    void close();
+    static bool write(string filename,
+        const map<int,map<double,int>>& bidDepthsLog,
+        const map<int,map<double,int>>& askDepthsLog,
+        int numLevels=0, int snapInterval=1);
+};
+
+class TradeLogFile {
+    // columnar trades: times, book ids, match ids, sizes, prices and
+    // directions (1 for a buy, -1 for a sell) as in the trades csv
+private:
+    MappedFile file;
+    const BinaryLogHeader* header;
+    Span<int> times, ids, matchIds, sizes, directions;
+    Span<double> prices;
+public:
+    static const int VERSION = 1;
+    /**** constructors ****/
+    TradeLogFile(): header(0) {}
+    TradeLogFile(string filename);
+    TradeLogFile(const TradeLogFile&) = delete;
+    TradeLogFile& operator=(const TradeLogFile&) = delete;
+    /**** accessors ****/
+    bool isOpen() const {return header!=0;}
+    string getFilename() const {return file.getFilename();}
+    long long getNumTrades() const {return (header)?header->numRows:0;}
+    Span<int> getTimes() const {return times;}
+    Span<int> getIds() const {return ids;}
+    Span<int> getMatchIds() const {return matchIds;}
+    Span<int> getSizes() const {return sizes;}
+    Span<double> getPrices() const {return prices;}
+    Span<int> getDirections() const {return directions;}
+    Trade getTrade(long long i) const;
+    vector<Trade> getTrades() const;
+    /**** main ****/
+    bool open(string filename);
+    void close();
+    static bool write(string filename, const vector<Trade>& trades);
+};
+
+#endif
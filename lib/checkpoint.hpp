@@ -0,0 +1,92 @@
+#ifndef CHECKPOINT_HPP
+#define CHECKPOINT_HPP
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+using namespace std;
+
+/**** class declarations ******************************************************/
+
+struct CheckpointHeader {
+    // 16-byte header of each section of a checkpoint, the values that follow
+    // are raw and in host byte order, so files move between builds of the
+    // same platform only
+    char magic[8]; // "OBSBOOK " or "OBSZISIM"
+    int version;
+    int flags; // CHECKPOINT_HISTORY
+};
+
+enum CheckpointFlag {CHECKPOINT_HISTORY=1}; // trades, orders log and depth logs kept
+
+/**** helper functions ********************************************************/
+
+inline void writeCheckpointHeader(ostream& out, const char* magic, int version, int flags) {
+    CheckpointHeader header;
+    memcpy(header.magic, magic, 8);
+    header.version = version;
+    header.flags = flags;
+    out.write((const char*)&header, sizeof(header));
+}
+
+inline bool readCheckpointHeader(istream& in, const char* magic, int version, int& flags) {
+    CheckpointHeader header;
+    if (!in.read((char*)&header, sizeof(header))) return false;
+    if (memcmp(header.magic, magic, 8) || header.version != version) return false;
+    flags = header.flags;
+    return true;
+}
+
+template <typename T>
+void writeBinary(ostream& out, const T& x) {
+    out.write((const char*)&x, sizeof(T));
+}
+
+template <typename T>
+bool readBinary(istream& in, T& x) {
+    return (bool)in.read((char*)&x, sizeof(T));
+}
+
+inline bool readBinary(istream& in, bool& b) {
+    // a corrupt byte is rejected rather than loaded as a bool
+    unsigned char c;
+    if (!readBinary(in, c) || c > 1) return false;
+    b = c;
+    return true;
+}
+
+inline void writeBinary(ostream& out, const string& s) {
+    writeBinary(out, (int)s.size());
+    out.write(s.data(), s.size());
+}
+
+inline bool readBinary(istream& in, string& s) {
+    int n;
+    if (!readBinary(in, n) || n < 0) return false;
+    s.resize(n);
+    return n == 0 || (bool)in.read(&s[0], n);
+}
+
+template <typename C>
+void writeBinaryItems(ostream& out, const C& items) {
+    // count, then the items of a container of strings or trivially
+    // copyable values
+    writeBinary(out, (long long)items.size());
+    for (auto& x : items) writeBinary(out, x);
+}
+
+template <typename C>
+bool readBinaryItems(istream& in, C& items) {
+    long long n;
+    if (!readBinary(in, n) || n < 0) return false;
+    items.clear();
+    typename C::value_type x;
+    for (long long i=0; i<n; i++) {
+        if (!readBinary(in, x)) return false;
+        items.push_back(x);
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,94 @@
+#ifndef CSVWRITER_CPP
+#define CSVWRITER_CPP
+#include <fstream>
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include <map>
+#include "side.hpp"
+#include "orderBook.hpp"
+#include "jsonWriter.hpp"
+#include "csvWriter.hpp"
+using namespace std;
+
+/**** class functions *********************************************************/
+//### CsvWriter class ##########################################################
+
+CsvWriter::CsvWriter(int numThreads, int blockRows): numThreads(max(1, numThreads)), blockRows(max(1, blockRows)), blocks(this->numThreads) {}
+
+string CsvWriter::getTradesHeader() {
+    return "TIME,ID,SIZE,PRICE,DIRECTION\n";
+}
+
+string CsvWriter::getDepthsHeader(int bookLevels) {
+    JsonWriter out;
+    out << "TIME";
+    for (int i=1; i<=bookLevels; i++) out << ",BID" << i << "_PRICE" << ",BID" << i << "_SIZE";
+    for (int i=1; i<=bookLevels; i++) out << ",ASK" << i << "_PRICE" << ",ASK" << i << "_SIZE";
+    out << "\n";
+    return out.str();
+}
+
+void CsvWriter::writeTradeRow(JsonWriter& out, const Trade& trade) {
+    int id        = trade.getId(); // bookOrder (LIM)
+    int price     = trade.getPrice();
+    int direction = (trade.getSide()==BID)?1:-1; // matchOrder (MKT)
+    out << trade.getTime() << "," << id << "," << trade.getSize() << "," << price << "," << direction << "\n";
+}
+
+template <typename F>
+bool CsvWriter::writeRows(string filename, const string& header, size_t numRows, F formatRow) {
+    // the calling thread formats the last range of each batch
+    ofstream f(filename, ios::binary);
+    if (!f) return false;
+    for (auto& block : blocks) block.clear();
+    blocks[0] << header;
+    size_t batchRows = (size_t)numThreads*blockRows;
+    for (size_t begin=0; begin<numRows; begin+=batchRows) {
+        int numRanges = (min(batchRows, numRows-begin)+blockRows-1)/blockRows;
+        vector<thread> workers;
+        for (int k=0; k<numRanges; k++) {
+            size_t first = begin+(size_t)k*blockRows, last = min(numRows, first+blockRows);
+            JsonWriter& block = blocks[k];
+            auto format = [&block, &formatRow, first, last]() {
+                for (size_t i=first; i<last; i++) formatRow(block, i);
+            };
+            if (k < numRanges-1) workers.push_back(thread(format));
+            else format();
+        }
+        for (auto& worker : workers) worker.join();
+        for (int k=0; k<numRanges; k++) blocks[k].writeTo(f);
+    }
+    blocks[0].writeTo(f);
+    f.close();
+    return !f.fail();
+}
+
+bool CsvWriter::writeTrades(string filename, const vector<Trade>& trades) {
+    return writeRows(filename, getTradesHeader(), trades.size(),
+        [&trades](JsonWriter& out, size_t i) {writeTradeRow(out, trades[i]);});
+}
+
+bool CsvWriter::writeDepthsLog(string filename, const map<int,map<double,int>>& bidDepthsLog, const map<int,map<double,int>>& askDepthsLog, int bookLevels) {
+    // one row per bid snapshot, bids from the best price down and asks from
+    // the best price up; rows point into the logs, nothing is copied
+    vector<int> times;
+    vector<const map<double,int>*> bids, asks;
+    times.reserve(bidDepthsLog.size());
+    bids.reserve(bidDepthsLog.size());
+    asks.reserve(bidDepthsLog.size());
+    for (auto& snap : bidDepthsLog) {
+        times.push_back(snap.first);
+        bids.push_back(&snap.second);
+        asks.push_back(&askDepthsLog.at(snap.first));
+    }
+    return writeRows(filename, getDepthsHeader(bookLevels), times.size(),
+        [&](JsonWriter& out, size_t i) {
+            out << times[i];
+            for (auto p=bids[i]->rbegin(); p!=bids[i]->rend(); p++) out << "," << p->first << "," << p->second;
+            for (auto p=asks[i]->begin(); p!=asks[i]->end(); p++) out << "," << p->first << "," << p->second;
+            out << "\n";
+        });
+}
+
+#endif
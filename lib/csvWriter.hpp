@@ -0,0 +1,39 @@
+#ifndef CSVWRITER_HPP
+#define CSVWRITER_HPP
+#include <string>
+#include <vector>
+#include <map>
+#include "orderBook.hpp"
+#include "jsonWriter.hpp"
+using namespace std;
+
+/**** class declarations ******************************************************/
+
+class CsvWriter {
+    // trades and depth logs as the csv read by python/main.py: rows are
+    // formatted into blocks and each block is written with one call; with
+    // numThreads>1 a batch of rows is split into ranges of blockRows rows
+    // formatted in parallel, and the blocks are written in row order
+private:
+    int numThreads;
+    int blockRows;
+    vector<JsonWriter> blocks; // one per thread, reused across batches
+    template <typename F>
+    bool writeRows(string filename, const string& header, size_t numRows, F formatRow);
+public:
+    /**** constructors ****/
+    CsvWriter(int numThreads=1, int blockRows=1<<14);
+    /**** accessors ****/
+    int getNumThreads() const {return numThreads;}
+    int getBlockRows() const {return blockRows;}
+    /**** main ****/
+    bool writeTrades(string filename, const vector<Trade>& trades);
+    bool writeDepthsLog(string filename,
+        const map<int,map<double,int>>& bidDepthsLog,
+        const map<int,map<double,int>>& askDepthsLog, int bookLevels);
+    static string getTradesHeader();
+    static string getDepthsHeader(int bookLevels);
+    static void writeTradeRow(JsonWriter& out, const Trade& trade);
+};
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef DEPTHJOURNAL_CPP
+#define DEPTHJOURNAL_CPP
+#include <algorithm>
+#include <vector>
+#include <map>
+#include "side.hpp"
+#include "priceLevels.hpp"
+#include "depthJournal.hpp"
+using namespace std;
+
+/**** class functions *********************************************************/
+//### DepthJournal class #######################################################
+
+DepthJournal::DepthJournal(int keyInterval): keyInterval(max(1,keyInterval)), offsets(1, 0) {}
+
+int DepthJournal::findSnap(int time) const {
+    // last snap at or before time, -1 if none
+    return upper_bound(times.begin(), times.end(), time)-times.begin()-1;
+}
+
+void DepthJournal::getDepths(int time, map<double,int>& bidDepths, map<double,int>& askDepths, int numLevels) const {
+    // book at the last snap at or before time, top numLevels of each side
+    bidDepths.clear();
+    askDepths.clear();
+    int snap = findSnap(time);
+    if (snap < 0) return;
+    for (long long i=offsets[snap/keyInterval*keyInterval]; i<offsets[snap+1]; i++) {
+        map<double,int>& depths = (entries[i].side==BID)?bidDepths:askDepths;
+        if (entries[i].depth) depths[entries[i].price] = entries[i].depth;
+        else depths.erase(entries[i].price);
+    }
+    if (numLevels > 0) {
+        while ((int)bidDepths.size() > numLevels) bidDepths.erase(bidDepths.begin());
+        while ((int)askDepths.size() > numLevels) askDepths.erase(prev(askDepths.end()));
+    }
+}
+
+map<double,int> DepthJournal::getBidDepths(int time, int numLevels) const {
+    map<double,int> bidDepths, askDepths;
+    getDepths(time, bidDepths, askDepths, numLevels);
+    return bidDepths;
+}
+
+map<double,int> DepthJournal::getAskDepths(int time, int numLevels) const {
+    map<double,int> bidDepths, askDepths;
+    getDepths(time, bidDepths, askDepths, numLevels);
+    return askDepths;
+}
+
+void DepthJournal::getDepthsLog(map<int,map<double,int>>& bidDepthsLog, map<int,map<double,int>>& askDepthsLog, int numLevels) const {
+    // every snap in one pass, as the full snapshots of ZeroIntelligence
+    map<double,int> bidDepths, askDepths;
+    for (int snap=0; snap<(int)times.size(); snap++) {
+        if (isKeyframe(snap)) {
+            bidDepths.clear();
+            askDepths.clear();
+        }
+        for (long long i=offsets[snap]; i<offsets[snap+1]; i++) {
+            map<double,int>& depths = (entries[i].side==BID)?bidDepths:askDepths;
+            if (entries[i].depth) depths[entries[i].price] = entries[i].depth;
+            else depths.erase(entries[i].price);
+        }
+        map<double,int>& b = bidDepthsLog[times[snap]];
+        map<double,int>& a = askDepthsLog[times[snap]];
+        b.clear();
+        a.clear();
+        for (auto i=bidDepths.rbegin(); i!=bidDepths.rend() && (numLevels<=0 || (int)b.size()<numLevels); i++) b.insert(b.begin(), *i);
+        for (auto i=askDepths.begin(); i!=askDepths.end() && (numLevels<=0 || (int)a.size()<numLevels); i++) a.insert(a.end(), *i);
+    }
+}
+
+int DepthJournal::setKeyInterval(int keyInterval) {
+    // recorded snaps depend on the interval, so the journal is cleared
+    clear();
+    this->keyInterval = max(1,keyInterval);
+    return this->keyInterval;
+}
+
+void DepthJournal::record(int time, PriceLevels& bids, PriceLevels& asks) {
+    // levels must be journaling, their changes since the last record are drained
+    updates.clear();
+    bids.drainChanges(updates);
+    int numBidUpdates = updates.size();
+    asks.drainChanges(updates);
+    if (isKeyframe(times.size())) {
+        for (int i=bids.getBest(); i>=0; i=bids.next(i))
+            entries.push_back({BID, bids.getDepth(i), bids.getPrice(i)});
+        for (int i=asks.getBest(); i>=0; i=asks.next(i))
+            entries.push_back({ASK, asks.getDepth(i), asks.getPrice(i)});
+    } else
+        for (int i=0; i<(int)updates.size(); i++)
+            entries.push_back({(i<numBidUpdates)?BID:ASK, updates[i].depth, updates[i].price});
+    times.push_back(time);
+    offsets.push_back(entries.size());
+}
+
+void DepthJournal::clear() {
+    times.clear();
+    offsets.assign(1, 0);
+    entries.clear();
+    updates.clear();
+}
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef DEPTHJOURNAL_HPP
+#define DEPTHJOURNAL_HPP
+#include <vector>
+#include <map>
+#include "side.hpp"
+#include "priceLevels.hpp"
+using namespace std;
+
+/**** class declarations ******************************************************/
+
+struct DepthEntry {
+    // level of a keyframe or a delta, depth 0 removes the level
+    Side side;
+    int depth;
+    double price;
+};
+
+class DepthJournal {
+    // delta depth log: each snap stores only the levels changed since the
+    // previous snap and every keyInterval-th snap is a keyframe of the whole
+    // book, so a logged time is rebuilt from at most keyInterval snaps
+private:
+    int keyInterval;
+    vector<int> times;
+    vector<long long> offsets; // entries of snap s are [offsets[s],offsets[s+1])
+    vector<DepthEntry> entries;
+    vector<LevelUpdate> updates; // drain buffer
+    int findSnap(int time) const;
+public:
+    /**** constructors ****/
+    DepthJournal(int keyInterval=1000);
+    /**** accessors ****/
+    int getKeyInterval() const {return keyInterval;}
+    int getNumSnaps() const {return times.size();}
+    long long getNumEntries() const {return entries.size();}
+    vector<int> getTimes() const {return times;}
+    bool isKeyframe(int snap) const {return snap%keyInterval == 0;}
+    void getDepths(int time, map<double,int>& bidDepths,
+        map<double,int>& askDepths, int numLevels=0) const;
+    map<double,int> getBidDepths(int time, int numLevels=0) const;
+    map<double,int> getAskDepths(int time, int numLevels=0) const;
+    void getDepthsLog(map<int,map<double,int>>& bidDepthsLog,
+        map<int,map<double,int>>& askDepthsLog, int numLevels=0) const;
+    /**** mutators ****/
+    int setKeyInterval(int keyInterval);
+    /**** main ****/
+    void record(int time, PriceLevels& bids, PriceLevels& asks);
+    void clear();
+};
+
+#endif
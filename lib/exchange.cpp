@@ -0,0 +1,139 @@
+#ifndef EXCHANGE_CPP
+#define EXCHANGE_CPP
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <map>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+#include "orderBook.hpp"
+#include "spscQueue.hpp"
+#include "exchange.hpp"
+using namespace std;
+
+/**** class functions *********************************************************/
+//### Exchange class ###########################################################
+
+Exchange::Exchange(int numShards, int numProducers, int queueSize, bool pinThreads): numShards(numShards), numProducers(numProducers), queueSize(queueSize), pinThreads(pinThreads), running(false) {
+    if (this->numShards <= 0) this->numShards = max(1, (int)thread::hardware_concurrency());
+    if (this->numProducers <= 0) this->numProducers = 1;
+    for (int s=0; s<this->numShards; s++) {
+        Shard* shard = new Shard;
+        shard->numProcessed = 0;
+        for (int p=0; p<this->numProducers; p++)
+            shard->queues.push_back(new SpscQueue<BookMsg>(queueSize));
+        shards.push_back(shard);
+    }
+}
+
+Exchange::~Exchange() {
+    stop();
+    for (auto shard : shards) {
+        for (auto q : shard->queues) delete q;
+        delete shard;
+    }
+    for (auto book : books) delete book;
+}
+
+int Exchange::getBookId(const string& symbol) const {
+    auto i = bookIds.find(symbol);
+    return (i==bookIds.end())?-1:i->second;
+}
+
+LimitOrderBook* Exchange::getBookPtr(const string& symbol) {
+    int book = getBookId(symbol);
+    return (book<0)?0:books[book];
+}
+
+long long Exchange::getNumProcessed() const {
+    long long numProcessed = 0;
+    for (auto shard : shards) numProcessed += shard->numProcessed.load(memory_order_relaxed);
+    return numProcessed;
+}
+
+int Exchange::addBook(string symbol, double tickSize, bool hugePages) {
+    if (running.load()) return -1;
+    int book = getBookId(symbol);
+    if (book >= 0) return book;
+    book = books.size();
+    books.push_back(new LimitOrderBook(symbol, tickSize, hugePages));
+    bookShards.push_back(book%numShards);
+    shards[book%numShards]->books.push_back(book);
+    bookIds[symbol] = book;
+    return book;
+}
+
+void Exchange::runShard(int shard) {
+    #ifdef __linux__
+    if (pinThreads) {
+        // pin to the shard-th cpu this process may run on
+        cpu_set_t allowed, cpus;
+        if (!sched_getaffinity(0, sizeof(allowed), &allowed) && CPU_COUNT(&allowed)) {
+            int k = shard%CPU_COUNT(&allowed);
+            for (int c=0; c<CPU_SETSIZE; c++)
+                if (CPU_ISSET(c, &allowed) && !k--) {
+                    CPU_ZERO(&cpus);
+                    CPU_SET(c, &cpus);
+                    pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+                    break;
+                }
+        }
+    }
+    #endif
+    Shard* s = shards[shard];
+    BookMsg m;
+    while (true) {
+        // read before draining, so everything submitted before stop() is matched
+        bool stopping = !running.load(memory_order_acquire);
+        long long n = 0;
+        for (auto q : s->queues)
+            for (int i=0; i<256 && q->pop(m); i++, n++)
+                books[m.book]->processOrder(m.msg);
+        if (n) s->numProcessed.fetch_add(n, memory_order_relaxed);
+        else if (stopping) break;
+        else this_thread::yield();
+    }
+}
+
+void Exchange::start() {
+    if (running.load()) return;
+    running.store(true, memory_order_release);
+    for (int s=0; s<numShards; s++)
+        shards[s]->worker = thread(&Exchange::runShard, this, s);
+}
+
+void Exchange::stop() {
+    if (!running.load()) return;
+    running.store(false, memory_order_release);
+    for (auto shard : shards)
+        if (shard->worker.joinable()) shard->worker.join();
+}
+
+bool Exchange::trySubmit(int producer, int book, const OrderMsg& msg) {
+    // false if the queue is full, and for ids out of range or while stopped
+    if (!running.load(memory_order_acquire)) return false;
+    if (producer < 0 || producer >= numProducers || book < 0 || book >= (int)bookShards.size()) return false;
+    BookMsg m;
+    m.book = book;
+    m.msg = msg;
+    return shards[bookShards[book]]->queues[producer]->push(m);
+}
+
+bool Exchange::submit(int producer, int book, const OrderMsg& msg) {
+    // waits for room in the queue, gives up once the exchange stops
+    if (producer < 0 || producer >= numProducers || book < 0 || book >= (int)bookShards.size()) return false;
+    while (!trySubmit(producer, book, msg))
+        if (!running.load(memory_order_acquire)) return false;
+        else this_thread::yield();
+    return true;
+}
+
+bool Exchange::submit(int producer, const string& symbol, const OrderMsg& msg) {
+    int book = getBookId(symbol);
+    return book >= 0 && submit(producer, book, msg);
+}
+
+#endif
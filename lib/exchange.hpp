@@ -0,0 +1,67 @@
+#ifndef EXCHANGE_HPP
+#define EXCHANGE_HPP
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <map>
+#include "orderBook.hpp"
+#include "spscQueue.hpp"
+using namespace std;
+
+/**** class declarations ******************************************************/
+
+struct BookMsg {
+    // order message routed to a book of the exchange
+    int book;
+    OrderMsg msg;
+};
+
+class Exchange {
+    // books are split into shards by book id, each shard is matched by one
+    // worker thread fed through an SPSC queue per producer, so every book
+    // stays single-threaded; books may only be read once the workers stop.
+    // Submits are rejected before start(), after stop() and for unknown
+    // producer or book ids; one racing stop() may be left unmatched
+private:
+    struct Shard {
+        vector<int> books;
+        vector<SpscQueue<BookMsg>*> queues; // one per producer
+        atomic<long long> numProcessed;
+        thread worker;
+    };
+    int numShards, numProducers, queueSize;
+    bool pinThreads;
+    atomic<bool> running;
+    vector<LimitOrderBook*> books;
+    vector<int> bookShards;
+    map<string,int> bookIds;
+    vector<Shard*> shards;
+    void runShard(int shard);
+public:
+    /**** constructors ****/
+    Exchange(int numShards=0, int numProducers=1, int queueSize=1<<16,
+        bool pinThreads=true);
+    Exchange(const Exchange&) = delete;
+    Exchange& operator=(const Exchange&) = delete;
+    ~Exchange();
+    /**** accessors ****/
+    int getNumShards() const {return numShards;}
+    int getNumProducers() const {return numProducers;}
+    int getNumBooks() const {return books.size();}
+    bool isRunning() const {return running.load();}
+    int getBookId(const string& symbol) const;
+    int getBookShard(int book) const {return bookShards[book];}
+    LimitOrderBook* getBookPtr(int book) {return books[book];}
+    LimitOrderBook* getBookPtr(const string& symbol);
+    long long getNumProcessed() const;
+    /**** mutators ****/
+    int addBook(string symbol, double tickSize=1, bool hugePages=false);
+    /**** main ****/
+    void start();
+    void stop();
+    bool trySubmit(int producer, int book, const OrderMsg& msg);
+    bool submit(int producer, int book, const OrderMsg& msg);
+    bool submit(int producer, const string& symbol, const OrderMsg& msg);
+};
+
+#endif
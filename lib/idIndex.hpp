@@ -0,0 +1,105 @@
+#ifndef IDINDEX_HPP
+#define IDINDEX_HPP
+#include <algorithm>
+#include <atomic>
+#include <vector>
+using namespace std;
+
+/**** class declarations ******************************************************/
+
+template <typename T>
+class IdIndex {
+    // maps non-negative order ids to pointers in pages of PAGE_SIZE ids;
+    // sequential ids keep pages dense and empty pages are recycled; pages
+    // shared with another index are copied before they are changed
+private:
+    static const int PAGE_BITS = 10;
+    static const int PAGE_SIZE = 1<<PAGE_BITS;
+    struct Page {
+        atomic<int> refs;
+        int count;
+        T* entries[PAGE_SIZE];
+    };
+    int size;
+    vector<Page*> pages;
+    vector<Page*> sparePages;
+    Page* newPage() {
+        Page* page;
+        if (sparePages.size()) {
+            page = sparePages.back();
+            sparePages.pop_back();
+        } else page = new Page;
+        page->refs.store(1, memory_order_relaxed);
+        return page;
+    }
+    void releasePage(Page* page) {
+        if (page->refs.fetch_sub(1, memory_order_acq_rel) == 1) sparePages.push_back(page);
+    }
+    Page* ownPage(int p) {
+        Page* page = pages[p];
+        if (page->refs.load(memory_order_acquire) > 1) {
+            pages[p] = newPage();
+            pages[p]->count = page->count;
+            copy(page->entries, page->entries+PAGE_SIZE, pages[p]->entries);
+            releasePage(page);
+        }
+        return pages[p];
+    }
+public:
+    /**** constructors ****/
+    IdIndex(): size(0) {}
+    IdIndex(const IdIndex&) = delete;
+    IdIndex& operator=(const IdIndex&) = delete;
+    ~IdIndex() {
+        clear();
+        for (auto p : sparePages) delete p;
+    }
+    /**** accessors ****/
+    int getSize() const {return size;}
+    T* get(int id) const {
+        if (id < 0 || (id>>PAGE_BITS) >= (int)pages.size()) return 0;
+        Page* page = pages[id>>PAGE_BITS];
+        return (page)?page->entries[id&(PAGE_SIZE-1)]:0;
+    }
+    /**** mutators ****/
+    void set(int id, T* ptr) {
+        if (id < 0 || !ptr) return;
+        int p = id>>PAGE_BITS;
+        if (p >= (int)pages.size()) pages.resize(p+1, 0);
+        if (!pages[p]) {
+            pages[p] = newPage();
+            pages[p]->count = 0;
+            fill(pages[p]->entries, pages[p]->entries+PAGE_SIZE, (T*)0);
+        }
+        Page* page = ownPage(p);
+        T** entry = &page->entries[id&(PAGE_SIZE-1)];
+        if (!*entry) {page->count++; size++;}
+        *entry = ptr;
+    }
+    void erase(int id) {
+        if (!get(id)) return;
+        int p = id>>PAGE_BITS;
+        Page* page = ownPage(p);
+        page->entries[id&(PAGE_SIZE-1)] = 0;
+        size--;
+        if (!--page->count) {
+            releasePage(page);
+            pages[p] = 0;
+        }
+    }
+    void share(const IdIndex& index) {
+        // same entries as index, sharing its pages until either changes them
+        clear();
+        pages = index.pages;
+        for (auto p : pages)
+            if (p) p->refs.fetch_add(1, memory_order_relaxed);
+        size = index.size;
+    }
+    void clear() {
+        for (auto& p : pages)
+            if (p) {releasePage(p); p = 0;}
+        size = 0;
+    }
+};
+
+#endif
@@ -0,0 +1,208 @@
+#ifndef ITCHREPLAY_CPP
+#define ITCHREPLAY_CPP
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "side.hpp"
+#include "orderType.hpp"
+#include "orderBook.hpp"
+#include "mappedFile.hpp"
+#include "itchReplay.hpp"
+using namespace std;
+
+/**** helper functions ********************************************************/
+
+static inline unsigned readU16(const unsigned char* p) {
+    return (p[0]<<8)|p[1];
+}
+
+static inline unsigned readU32(const unsigned char* p) {
+    return ((unsigned)p[0]<<24)|(p[1]<<16)|(p[2]<<8)|p[3];
+}
+
+static inline unsigned long long readU48(const unsigned char* p) {
+    return ((unsigned long long)readU16(p)<<32)|readU32(p+2);
+}
+
+static inline unsigned long long readU64(const unsigned char* p) {
+    return ((unsigned long long)readU32(p)<<32)|readU32(p+4);
+}
+
+static inline double readPrice(const unsigned char* p) {
+    return readU32(p)/1e4; // Price(4)
+}
+
+/**** class functions *********************************************************/
+//### ItchReplay class #########################################################
+
+ItchReplay::ItchReplay(string filename, double tickSize): pos(0), tickSize(tickSize), numMessages(0), numApplied(0), timestamp(0), counts(256, 0) {
+    if (filename != "") open(filename);
+}
+
+ItchReplay::~ItchReplay() {
+    reset();
+}
+
+int ItchReplay::getNumBooks() const {
+    int numBooks = 0;
+    for (auto book : books) numBooks += (book!=0);
+    return numBooks;
+}
+
+long long ItchReplay::getNumTrades() const {
+    long long numTrades = 0;
+    for (auto book : books) if (book) numTrades += book->getTradesPtr()->size();
+    return numTrades;
+}
+
+string ItchReplay::getBookName(int locate) const {
+    if (locate>=0 && locate<(int)names.size() && names[locate]!="") return names[locate];
+    return "LOCATE"+to_string(locate);
+}
+
+bool ItchReplay::open(string filename) {
+    reset();
+    return file.open(filename, true);
+}
+
+void ItchReplay::close() {
+    file.close();
+    pos = 0;
+}
+
+void ItchReplay::reset() {
+    // back to the start of the file with no books
+    for (auto book : books) delete book;
+    books.clear();
+    names.clear();
+    nextIds.clear();
+    orders.clear();
+    fill(counts.begin(), counts.end(), 0);
+    pos = 0;
+    numMessages = numApplied = 0;
+    timestamp = 0;
+}
+
+LimitOrderBook* ItchReplay::makeBook(int locate) {
+    if (locate >= (int)books.size()) {
+        books.resize(locate+1, 0);
+        nextIds.resize(locate+1, 0);
+    }
+    if (!books[locate]) {
+        books[locate] = new LimitOrderBook(getBookName(locate), tickSize);
+        books[locate]->setOrdersLogMode(LOG_OFF);
+    }
+    return books[locate];
+}
+
+void ItchReplay::addOrder(int locate, unsigned long long ref, Side side, int size, double price) {
+    // rested without matching, the exchange's book never crosses and its
+    // fills come as executions
+    LimitOrderBook* book = makeBook(locate);
+    ItchOrder order = {locate, nextIds[locate]++, size, side, price};
+    book->processResting(OrderMsg(LIMIT, order.id, getTime(), 0, side, size, price));
+    orders[ref] = order;
+}
+
+void ItchReplay::executeOrder(unsigned long long ref, int size, double price) {
+    // fills the order in place and records the trade at price, at the
+    // order's price if negative
+    auto i = orders.find(ref);
+    if (i == orders.end()) return;
+    ItchOrder& order = i->second;
+    LimitOrderBook* book = books[order.book];
+    book->setClock(getTime());
+    order.size -= book->processExecution(order.id, size, (price<0)?order.price:price, nextIds[order.book]++);
+    if (order.size <= 0) orders.erase(i);
+}
+
+void ItchReplay::reduceOrder(unsigned long long ref, int size) {
+    // partial cancels shrink the order in place
+    auto i = orders.find(ref);
+    if (i == orders.end()) return;
+    ItchOrder& order = i->second;
+    order.size -= size;
+    books[order.book]->processOrder(OrderMsg(MODIFY, nextIds[order.book]++, getTime(), 0, order.id, order.size, order.price));
+    if (order.size <= 0) orders.erase(i);
+}
+
+void ItchReplay::deleteOrder(unsigned long long ref) {
+    auto i = orders.find(ref);
+    if (i == orders.end()) return;
+    ItchOrder& order = i->second;
+    books[order.book]->processOrder(OrderMsg(CANCEL, nextIds[order.book]++, getTime(), 0, order.id));
+    orders.erase(i);
+}
+
+void ItchReplay::replaceOrder(unsigned long long ref, unsigned long long newRef, int size, double price) {
+    // the new order loses priority, as on the exchange
+    auto i = orders.find(ref);
+    if (i == orders.end()) return;
+    int locate = i->second.book;
+    Side side = i->second.side;
+    deleteOrder(ref);
+    addOrder(locate, newRef, side, size, price);
+}
+
+bool ItchReplay::apply(const unsigned char* msg, int length) {
+    // offsets and lengths as in the ITCH 5.0 specification
+    if (length < 11) return false;
+    int locate = readU16(msg+1);
+    timestamp = readU48(msg+5);
+    switch (msg[0]) {
+        case 'R':
+            if (length < 39) return false;
+            if (locate >= (int)names.size()) names.resize(locate+1);
+            names[locate] = string((const char*)msg+11, 8);
+            names[locate].erase(names[locate].find_last_not_of(' ')+1);
+            return true;
+        case 'A': case 'F':
+            if (length < 36) return false;
+            addOrder(locate, readU64(msg+11), (msg[19]=='B')?BID:ASK, readU32(msg+20), readPrice(msg+32));
+            return true;
+        case 'E':
+            if (length < 31) return false;
+            executeOrder(readU64(msg+11), readU32(msg+19));
+            return true;
+        case 'C':
+            if (length < 36) return false;
+            executeOrder(readU64(msg+11), readU32(msg+19), readPrice(msg+32));
+            return true;
+        case 'X':
+            if (length < 23) return false;
+            reduceOrder(readU64(msg+11), readU32(msg+19));
+            return true;
+        case 'D':
+            if (length < 19) return false;
+            deleteOrder(readU64(msg+11));
+            return true;
+        case 'U':
+            if (length < 35) return false;
+            replaceOrder(readU64(msg+11), readU64(msg+19), readU32(msg+27), readPrice(msg+31));
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool ItchReplay::step() {
+    // one message, false at the end of the file or on a truncated message
+    if (pos+2 > file.getSize()) return false;
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(file.getData()+pos);
+    int length = readU16(p);
+    if (!length || pos+2+length > file.getSize()) return false;
+    pos += 2+length;
+    counts[p[2]]++;
+    numApplied += apply(p+2, length);
+    numMessages++;
+    return true;
+}
+
+long long ItchReplay::replay(long long maxMessages) {
+    long long n = 0;
+    while ((!maxMessages || n < maxMessages) && step()) n++;
+    return n;
+}
+
+#endif
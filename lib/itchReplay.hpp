@@ -0,0 +1,76 @@
+#ifndef ITCHREPLAY_HPP
+#define ITCHREPLAY_HPP
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "side.hpp"
+#include "orderBook.hpp"
+#include "mappedFile.hpp"
+using namespace std;
+
+/**** class declarations ******************************************************/
+
+struct ItchOrder {
+    // live ITCH order: its book (stock locate), id in that book and the
+    // shares left
+    int book;
+    int id;
+    int size;
+    Side side;
+    double price;
+};
+
+class ItchReplay {
+    // decodes a memory-mapped NASDAQ ITCH 5.0 file, each message preceded by
+    // its 2-byte big-endian length, in place and replays add (A/F), execute
+    // (E/C), cancel (X), delete (D) and replace (U) messages into one book
+    // per stock locate; ITCH order refs map to sequential ids of each book
+    // and orders are stamped with the ITCH timestamp in ms since midnight.
+    // Adds rest without matching and executions are recorded as trades
+private:
+    MappedFile file;
+    size_t pos;
+    double tickSize;
+    long long numMessages, numApplied;
+    unsigned long long timestamp; // ns since midnight of the last message
+    vector<long long> counts; // messages by type
+    vector<LimitOrderBook*> books; // by stock locate
+    vector<string> names;
+    vector<int> nextIds;
+    unordered_map<unsigned long long,ItchOrder> orders;
+    int getTime() const {return timestamp/1000000;}
+    LimitOrderBook* makeBook(int locate);
+    void addOrder(int locate, unsigned long long ref, Side side, int size, double price);
+    void executeOrder(unsigned long long ref, int size, double price=-1);
+    void reduceOrder(unsigned long long ref, int size);
+    void deleteOrder(unsigned long long ref);
+    void replaceOrder(unsigned long long ref, unsigned long long newRef, int size, double price);
+    bool apply(const unsigned char* msg, int length);
+public:
+    /**** constructors ****/
+    ItchReplay(string filename="", double tickSize=0.01);
+    ItchReplay(const ItchReplay&) = delete;
+    ItchReplay& operator=(const ItchReplay&) = delete;
+    ~ItchReplay();
+    /**** accessors ****/
+    bool isOpen() const {return file.isOpen();}
+    size_t getPos() const {return pos;}
+    size_t getFileSize() const {return file.getSize();}
+    long long getNumMessages() const {return numMessages;}
+    long long getNumApplied() const {return numApplied;}
+    long long getCount(char type) const {return counts[(unsigned char)type];}
+    unsigned long long getTimestamp() const {return timestamp;}
+    int getNumBooks() const;
+    int getNumLiveOrders() const {return orders.size();}
+    long long getNumTrades() const;
+    LimitOrderBook* getBookPtr(int locate) {return (locate>=0 && locate<(int)books.size())?books[locate]:0;}
+    string getBookName(int locate) const;
+    /**** main ****/
+    bool open(string filename);
+    void close();
+    void reset();
+    bool step();
+    long long replay(long long maxMessages=0);
+};
+
+#endif
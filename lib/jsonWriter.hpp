@@ -0,0 +1,77 @@
+#ifndef JSONWRITER_HPP
+#define JSONWRITER_HPP
+#include <cstdio>
+#include <cmath>
+#include <iostream>
+#include <string>
+using namespace std;
+
+/**** class declarations ******************************************************/
+
+class JsonWriter {
+    // JSON text appended to a growable buffer that keeps its capacity across
+    // clear() and writeTo(), numbers are formatted in place without streams;
+    // the util.cpp printers accept it in place of an ostream
+private:
+    string buf;
+    void appendUnsigned(unsigned long long x) {
+        char tmp[24];
+        char* p = tmp+sizeof(tmp);
+        do {*--p = '0'+x%10; x /= 10;} while (x);
+        buf.append(p, tmp+sizeof(tmp)-p);
+    }
+public:
+    /**** constructors ****/
+    JsonWriter(size_t capacity=1<<12) {buf.reserve(capacity);}
+    /**** accessors ****/
+    const char* data() const {return buf.data();}
+    size_t size() const {return buf.size();}
+    size_t capacity() const {return buf.capacity();}
+    bool empty() const {return buf.empty();}
+    string str() const {return buf;}
+    /**** mutators ****/
+    void clear() {buf.clear();}
+    void reserve(size_t capacity) {buf.reserve(capacity);}
+    JsonWriter& append(const char* s, size_t n) {buf.append(s, n); return *this;}
+    /**** main ****/
+    void writeTo(ostream& out) {
+        // hands the text over and empties the buffer, for streaming per event
+        out.write(buf.data(), buf.size());
+        buf.clear();
+    }
+    /**** operators ****/
+    JsonWriter& operator<<(char c) {buf += c; return *this;}
+    JsonWriter& operator<<(const char* s) {buf += s; return *this;}
+    JsonWriter& operator<<(const string& s) {buf += s; return *this;}
+    JsonWriter& operator<<(int x) {return *this << (long long)x;}
+    JsonWriter& operator<<(long long x) {
+        if (x < 0) buf += '-';
+        appendUnsigned((x<0)?0ULL-(unsigned long long)x:(unsigned long long)x);
+        return *this;
+    }
+    JsonWriter& operator<<(double x) {
+        // same text as ostream's default (%g, 6 significant digits): values
+        // with up to 6 digits and 4 decimals, e.g. prices, are written
+        // directly and anything else goes through snprintf
+        double a = fabs(x);
+        long long scale = 1;
+        for (int dec=0; a<1e6 && dec<=4; dec++, scale*=10) {
+            double v = a*scale;
+            long long r = llround(v);
+            if (fabs(v-r) > v*1e-12) continue;
+            if (r >= 1000000) break;
+            if (signbit(x)) buf += '-';
+            appendUnsigned(r/scale);
+            if (!dec) return *this;
+            buf += '.';
+            for (long long d=scale/10; d; d/=10) buf += '0'+(r/d)%10;
+            return *this;
+        }
+        char tmp[32];
+        int n = snprintf(tmp, sizeof(tmp), "%g", x);
+        buf.append(tmp, n);
+        return *this;
+    }
+};
+
+#endif
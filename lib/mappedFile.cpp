@@ -0,0 +1,47 @@
+#ifndef MAPPEDFILE_CPP
+#define MAPPEDFILE_CPP
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "mappedFile.hpp"
+using namespace std;
+
+/**** class functions *********************************************************/
+//### MappedFile class #########################################################
+
+MappedFile::MappedFile(string filename): data(0), size(0) {
+    open(filename);
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(string filename, bool sequential) {
+    // empty or unreadable files stay closed
+    close();
+    this->filename = filename;
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (!fstat(fd, &st) && st.st_size > 0) {
+        void* p = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+            if (sequential) madvise(p, st.st_size, MADV_SEQUENTIAL);
+            data = static_cast<const char*>(p);
+            size = st.st_size;
+        }
+    }
+    ::close(fd);
+    return isOpen();
+}
+
+void MappedFile::close() {
+    if (data) munmap(const_cast<char*>(data), size);
+    data = 0;
+    size = 0;
+}
+
+#endif
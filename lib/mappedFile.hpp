@@ -0,0 +1,33 @@
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+#include <cstddef>
+#include <string>
+using namespace std;
+
+/**** class declarations ******************************************************/
+
+class MappedFile {
+    // read-only memory map of a whole file, pages are loaded by the kernel
+    // on first touch so opening costs the same for any file size
+private:
+    string filename;
+    const char* data;
+    size_t size;
+public:
+    /**** constructors ****/
+    MappedFile(): data(0), size(0) {}
+    MappedFile(string filename);
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+    /**** accessors ****/
+    string getFilename() const {return filename;}
+    const char* getData() const {return data;}
+    size_t getSize() const {return size;}
+    bool isOpen() const {return data!=0;}
+    /**** main ****/
+    bool open(string filename, bool sequential=false);
+    void close();
+};
+
+#endif
@@ -0,0 +1,134 @@
+#ifndef MARKETDATAFEED_CPP
+#define MARKETDATAFEED_CPP
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include "side.hpp"
+#include "orderBook.hpp"
+#include "priceLevels.hpp"
+#include "marketDataFeed.hpp"
+using namespace std;
+
+/**** class functions *********************************************************/
+//### MarketDataFeed class #####################################################
+
+MarketDataFeed::MarketDataFeed(LimitOrderBook* book, int conflateEvents, int conflateTime): book(book), seq(0), conflateEvents(conflateEvents), conflateTime(conflateTime), numPendingEvents(0), windowStart(0) {
+    book->setJournaling(true);
+}
+
+void MarketDataFeed::setConflation(int conflateEvents, int conflateTime) {
+    flush();
+    this->conflateEvents = conflateEvents;
+    this->conflateTime = conflateTime;
+}
+
+void MarketDataFeed::emit(Side side, const LevelUpdate& update, int time) {
+    if (update.depth == update.prevDepth) return;
+    LevelMsg msg;
+    msg.seq = ++seq;
+    msg.price = update.price;
+    msg.time = time;
+    msg.size = update.depth;
+    msg.action = (!update.prevDepth)?LEVEL_ADD:(!update.depth)?LEVEL_DELETE:LEVEL_UPDATE;
+    msg.side = side;
+    msg.reserved = 0;
+    msgs.push_back(msg);
+}
+
+void MarketDataFeed::conflate(int s) {
+    // merges the drained updates of side s into its pending changes
+    PriceLevels* levels = (s==0)?book->getBidLevelsPtr():book->getAskLevelsPtr();
+    for (auto& u : updates) {
+        auto i = pendingIdx[s].insert(make_pair(levels->getTick(u.price), (int)pending[s].size()));
+        if (i.second) pending[s].push_back(u);
+        else pending[s][i.first->second].depth = u.depth;
+    }
+}
+
+void MarketDataFeed::publish() {
+    int time = book->getClock();
+    if (!isConflating()) {
+        for (int s=0; s<2; s++) {
+            updates.clear();
+            ((s==0)?book->getBidLevelsPtr():book->getAskLevelsPtr())->drainChanges(updates);
+            for (auto& u : updates) emit((s==0)?BID:ASK, u, time);
+        }
+        return;
+    }
+    if (!numPendingEvents) windowStart = time;
+    for (int s=0; s<2; s++) {
+        updates.clear();
+        ((s==0)?book->getBidLevelsPtr():book->getAskLevelsPtr())->drainChanges(updates);
+        conflate(s);
+    }
+    numPendingEvents++;
+    if ((conflateEvents>1 && numPendingEvents>=conflateEvents) || (conflateTime>0 && time-windowStart>=conflateTime)) flush();
+}
+
+void MarketDataFeed::flush() {
+    // closes the conflation window
+    int time = book->getClock();
+    for (int s=0; s<2; s++) {
+        for (auto& u : pending[s]) emit((s==0)?BID:ASK, u, time);
+        pending[s].clear();
+        pendingIdx[s].clear();
+    }
+    numPendingEvents = 0;
+}
+
+vector<LevelMsg> MarketDataFeed::snapshot() {
+    // every level as an add at the current seq, for consumers joining late
+    // or recovering from a gap
+    publish();
+    flush();
+    vector<LevelMsg> snap;
+    for (int s=0; s<2; s++) {
+        const PriceLevels* levels = (s==0)?book->getBidLevelsPtr():book->getAskLevelsPtr();
+        for (int i=levels->getBest(); i>=0; i=levels->next(i)) {
+            LevelMsg msg;
+            msg.seq = seq;
+            msg.price = levels->getPrice(i);
+            msg.time = book->getClock();
+            msg.size = levels->getDepth(i);
+            msg.action = LEVEL_ADD;
+            msg.side = (s==0)?BID:ASK;
+            msg.reserved = 0;
+            snap.push_back(msg);
+        }
+    }
+    return snap;
+}
+
+int MarketDataFeed::poll(vector<LevelMsg>& out) {
+    // hands over the messages published since the last poll
+    out.clear();
+    out.swap(msgs);
+    return out.size();
+}
+
+//### MarketDataBook class #####################################################
+
+bool MarketDataBook::apply(const LevelMsg& msg) {
+    // messages at or before the current seq are already in the book, as
+    // after a snapshot, and are skipped
+    if (gap || msg.seq <= seq) return false;
+    if (msg.seq != seq+1) {
+        gap = true;
+        return false;
+    }
+    seq = msg.seq;
+    map<double,int>& depths = (msg.side==BID)?bidDepths:askDepths;
+    if (msg.action == LEVEL_DELETE) depths.erase(msg.price);
+    else depths[msg.price] = msg.size;
+    return true;
+}
+
+void MarketDataBook::applySnapshot(const vector<LevelMsg>& msgs, long long seq) {
+    bidDepths.clear();
+    askDepths.clear();
+    for (auto& msg : msgs) ((msg.side==BID)?bidDepths:askDepths)[msg.price] = msg.size;
+    this->seq = seq;
+    gap = false;
+}
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef MARKETDATAFEED_HPP
+#define MARKETDATAFEED_HPP
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include "side.hpp"
+#include "orderBook.hpp"
+#include "priceLevels.hpp"
+using namespace std;
+
+/**** class declarations ******************************************************/
+
+enum LevelAction {LEVEL_ADD=1, LEVEL_UPDATE, LEVEL_DELETE};
+
+struct LevelMsg {
+    // 32-byte market-by-price message, size is the new size of the level
+    // and 0 on delete; seq numbers are consecutive from 1
+    long long seq;
+    double price;
+    int time;
+    int size;
+    unsigned char action; // LevelAction
+    unsigned char side; // Side
+    short reserved;
+};
+
+class MarketDataFeed {
+    // incremental L2 feed of a book: publish() after each book change drains
+    // the changed levels from the book's journal, which the feed then owns,
+    // into add, update and delete messages; with conflation, changes to a
+    // level are merged until the window of events or clock time closes
+private:
+    LimitOrderBook* book;
+    long long seq;
+    int conflateEvents, conflateTime; // 0 for no window
+    int numPendingEvents, windowStart;
+    vector<LevelUpdate> updates; // drain buffer
+    vector<LevelUpdate> pending[2]; // conflated bid and ask changes
+    unordered_map<long long,int> pendingIdx[2]; // tick to index in pending
+    vector<LevelMsg> msgs;
+    void emit(Side side, const LevelUpdate& update, int time);
+    void conflate(int s);
+public:
+    /**** constructors ****/
+    MarketDataFeed(LimitOrderBook* book, int conflateEvents=0, int conflateTime=0);
+    MarketDataFeed(const MarketDataFeed&) = delete;
+    MarketDataFeed& operator=(const MarketDataFeed&) = delete;
+    /**** accessors ****/
+    long long getSeq() const {return seq;}
+    int getConflateEvents() const {return conflateEvents;}
+    int getConflateTime() const {return conflateTime;}
+    bool isConflating() const {return conflateEvents>1 || conflateTime>0;}
+    vector<LevelMsg>* getMsgsPtr() {return &msgs;}
+    /**** mutators ****/
+    void setConflation(int conflateEvents, int conflateTime=0);
+    /**** main ****/
+    void publish();
+    void flush();
+    vector<LevelMsg> snapshot();
+    int poll(vector<LevelMsg>& out);
+};
+
+class MarketDataBook {
+    // consumer side of the feed, rebuilds the levels from the messages and
+    // stops at the first sequence gap until it is given a new snapshot
+private:
+    long long seq;
+    bool gap;
+    map<double,int> bidDepths, askDepths;
+public:
+    /**** constructors ****/
+    MarketDataBook(): seq(0), gap(false) {}
+    /**** accessors ****/
+    long long getSeq() const {return seq;}
+    bool hasGap() const {return gap;}
+    map<double,int> getBidDepths() const {return bidDepths;}
+    map<double,int> getAskDepths() const {return askDepths;}
+    /**** main ****/
+    bool apply(const LevelMsg& msg);
+    void applySnapshot(const vector<LevelMsg>& msgs, long long seq);
+};
+
+#endif
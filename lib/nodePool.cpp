@@ -0,0 +1,48 @@
+#ifndef NODEPOOL_CPP
+#define NODEPOOL_CPP
+#include <new>
+#include <algorithm>
+#include <vector>
+#include <sys/mman.h>
+#include "nodePool.hpp"
+using namespace std;
+
+/**** class functions *********************************************************/
+//### NodePool class ###########################################################
+
+NodePool::NodePool(size_t nodeSize, bool hugePages, size_t slabSize): nodeSize((max(nodeSize,sizeof(FreeNode))+15)/16*16), slabSize(slabSize), hugePages(hugePages), numAllocated(0), slabPos(0), slabEnd(0), freeNodes(0), remoteNodes(0), numRemote(0) {
+    if (this->slabSize < this->nodeSize) this->slabSize = this->nodeSize;
+}
+
+NodePool::~NodePool() {
+    for (auto s : slabs) munmap(s, slabSize);
+}
+
+void NodePool::allocateSlab() {
+    // slabs are mapped lazily, so untouched nodes cost no resident memory
+    void* slab = MAP_FAILED;
+    #ifdef MAP_HUGETLB
+    if (hugePages) slab = mmap(0, slabSize, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_HUGETLB, -1, 0);
+    #endif
+    if (slab == MAP_FAILED) {
+        slab = mmap(0, slabSize, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+        if (slab == MAP_FAILED) throw bad_alloc();
+        #ifdef MADV_HUGEPAGE
+        if (hugePages) madvise(slab, slabSize, MADV_HUGEPAGE);
+        #endif
+    }
+    slabs.push_back(slab);
+    slabPos = static_cast<char*>(slab);
+    slabEnd = slabPos+slabSize/nodeSize*nodeSize;
+}
+
+void NodePool::takeRemote() {
+    // the whole remote list is taken at once, so pushes never race a pop
+    int n = 0;
+    freeNodes = remoteNodes.exchange(0, memory_order_acquire);
+    for (FreeNode* node=freeNodes; node; node=node->next) n++;
+    numAllocated -= n;
+    numRemote.fetch_sub(n, memory_order_relaxed);
+}
+
+#endif
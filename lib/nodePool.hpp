@@ -0,0 +1,81 @@
+#ifndef NODEPOOL_HPP
+#define NODEPOOL_HPP
+#include <cstddef>
+#include <atomic>
+#include <new>
+#include <utility>
+#include <vector>
+using namespace std;
+
+/**** class declarations ******************************************************/
+
+class NodePool {
+    // slab allocator of fixed-size nodes, recycled through a free list;
+    // other threads hand nodes back through deallocateRemote, which are
+    // taken over once the free list runs dry
+private:
+    struct FreeNode {FreeNode* next;};
+    size_t nodeSize, slabSize;
+    bool hugePages;
+    int numAllocated;
+    char* slabPos; // bump pointer into the newest slab
+    char* slabEnd;
+    FreeNode* freeNodes;
+    atomic<FreeNode*> remoteNodes;
+    atomic<int> numRemote; // remote nodes not yet taken over
+    vector<void*> slabs;
+    void allocateSlab();
+    void takeRemote();
+public:
+    /**** constructors ****/
+    NodePool(size_t nodeSize, bool hugePages=false, size_t slabSize=1<<21);
+    NodePool(const NodePool&) = delete;
+    NodePool& operator=(const NodePool&) = delete;
+    ~NodePool();
+    /**** accessors ****/
+    size_t getNodeSize() const {return nodeSize;}
+    size_t getSlabSize() const {return slabSize;}
+    bool getHugePages() const {return hugePages;}
+    int getNumAllocated() const {return numAllocated-numRemote.load(memory_order_relaxed);}
+    int getNumSlabs() const {return slabs.size();}
+    /**** main ****/
+    void* allocate() {
+        numAllocated++;
+        if (!freeNodes && remoteNodes.load(memory_order_relaxed)) takeRemote();
+        if (freeNodes) {
+            FreeNode* node = freeNodes;
+            freeNodes = node->next;
+            return node;
+        }
+        if (slabPos == slabEnd) allocateSlab();
+        void* node = slabPos;
+        slabPos += nodeSize;
+        return node;
+    }
+    void deallocate(void* ptr) {
+        numAllocated--;
+        FreeNode* node = static_cast<FreeNode*>(ptr);
+        node->next = freeNodes;
+        freeNodes = node;
+    }
+    void deallocateRemote(void* ptr) {
+        FreeNode* node = static_cast<FreeNode*>(ptr);
+        node->next = remoteNodes.load(memory_order_relaxed);
+        while (!remoteNodes.compare_exchange_weak(node->next, node, memory_order_release, memory_order_relaxed));
+        numRemote.fetch_add(1, memory_order_relaxed);
+    }
+    template <typename T, typename... Args>
+    T* create(Args&&... args) {
+        static_assert(alignof(T) <= 16, "node alignment");
+        if (sizeof(T) > nodeSize) throw bad_alloc();
+        return new (allocate()) T(forward<Args>(args)...);
+    }
+    template <typename T>
+    void destroy(T* ptr) {
+        if (!ptr) return;
+        ptr->~T();
+        deallocate(ptr);
+    }
+};
+
+#endif
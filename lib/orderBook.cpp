@@ -1,7 +1,11 @@
 #ifndef ORDERBOOK_CPP
 #define ORDERBOOK_CPP
 #include <iostream>
+#include <fstream>
 #include <sstream>
+#include <limits>
+#include <climits>
+#include <stdexcept>
 #include <algorithm>
 #include <vector>
 #include <deque>
@@ -9,26 +13,50 @@
 #include "util.cpp"
 #include "side.hpp"
 #include "orderType.hpp"
+#include "priceLevels.hpp"
+#include "orderLog.hpp"
+#include "jsonWriter.hpp"
+#include "checkpoint.hpp"
 #include "orderBook.hpp"
 using namespace std;
 
-/**** global variables ********************************************************/
-
-int TRADES_CLOCK = 0; // clock for trades log
-
 /**** helper functions ********************************************************/
 
 bool match(Side side, double limit, double price) {
     return (side==BID)?(price<=limit):((side==ASK)?(price>=limit):false);
 }
 
-int getTradesClock() {
-    return TRADES_CLOCK;
+static const char* getSideName(Side side) {
+    switch(side) {
+        case BID:       return "BID";
+        case ASK:       return "ASK";
+        case NULL_SIDE: return "NULL";
+        default:        return "NULL";
+    }
+}
+
+static const char* getTypeName(OrderType type) {
+    switch(type) {
+        case LIMIT:    return "LIMIT";
+        case MARKET:   return "MARKET";
+        case CANCEL:   return "CANCEL";
+        case MODIFY:   return "MODIFY";
+        case NULL_ORD: return "NULL";
+        default:       return "NULL";
+    }
 }
 
-int setTradesClock(int time) {
-    TRADES_CLOCK = time;
-    return TRADES_CLOCK;
+static void writeLimitJson(JsonWriter& out, int id, int time, const string& name, Side side, int size, double price) {
+    // shared by limit orders and the resting nodes of the book
+    out << "{" <<
+    "\"id\":"     << id    << "," <<
+    "\"time\":"   << time  << "," <<
+    "\"name\":\"" << name  << "\"," <<
+    "\"type\":\"" << LIMIT << "\"," <<
+    "\"side\":\"" << side  << "\"," <<
+    "\"size\":"   << size  << "," <<
+    "\"price\":"  << price <<
+    "}";
 }
 
 /**** class functions *********************************************************/
@@ -49,14 +77,18 @@ string Order::read() const {
 }
 
 string Order::getAsJson() const {
-    ostringstream oss;
-    oss << "{" <<
-    "\"id\":"     << getId()   << "," <<
-    "\"time\":"   << getTime() << "," <<
-    "\"name\":\"" << getName() << "\"," <<
-    "\"type\":\"" << getType() << "\"" <<
+    JsonWriter out(256);
+    writeJson(out);
+    return out.str();
+}
+
+void Order::writeJson(JsonWriter& out) const {
+    out << "{" <<
+    "\"id\":"     << getId()       << "," <<
+    "\"time\":"   << getTime()     << "," <<
+    "\"name\":\"" << *getNamePtr() << "\"," <<
+    "\"type\":\"" << getType()     << "\"" <<
     "}";
-    return oss.str();
 }
 
 int Order::setId(int id) {
@@ -95,18 +127,8 @@ string LimitOrder::read() const {
     return oss.str();
 }
 
-string LimitOrder::getAsJson() const {
-    ostringstream oss;
-    oss << "{" <<
-    "\"id\":"     << getId()    << "," <<
-    "\"time\":"   << getTime()  << "," <<
-    "\"name\":\"" << getName()  << "\"," <<
-    "\"type\":\"" << getType()  << "\"," <<
-    "\"side\":\"" << getSide()  << "\"," <<
-    "\"size\":"   << getSize()  << "," <<
-    "\"price\":"  << getPrice() <<
-    "}";
-    return oss.str();
+void LimitOrder::writeJson(JsonWriter& out) const {
+    writeLimitJson(out, getId(), getTime(), *getNamePtr(), getSide(), getSize(), getPrice());
 }
 
 Side LimitOrder::setSide(Side side) {
@@ -145,17 +167,15 @@ string MarketOrder::read() const {
     return oss.str();
 }
 
-string MarketOrder::getAsJson() const {
-    ostringstream oss;
-    oss << "{" <<
-    "\"id\":"     << getId()   << "," <<
-    "\"time\":"   << getTime() << "," <<
-    "\"name\":\"" << getName() << "\"," <<
-    "\"type\":\"" << getType() << "\"," <<
-    "\"side\":\"" << getSide() << "\"," <<
-    "\"size\":"   << getSize() <<
+void MarketOrder::writeJson(JsonWriter& out) const {
+    out << "{" <<
+    "\"id\":"     << getId()       << "," <<
+    "\"time\":"   << getTime()     << "," <<
+    "\"name\":\"" << *getNamePtr() << "\"," <<
+    "\"type\":\"" << getType()     << "\"," <<
+    "\"side\":\"" << getSide()     << "\"," <<
+    "\"size\":"   << getSize()     <<
     "}";
-    return oss.str();
 }
 
 Side MarketOrder::setSide(Side side) {
@@ -184,16 +204,14 @@ string CancelOrder::read() const {
     return oss.str();
 }
 
-string CancelOrder::getAsJson() const {
-    ostringstream oss;
-    oss << "{" <<
-    "\"id\":"     << getId()    << "," <<
-    "\"time\":"   << getTime()  << "," <<
-    "\"name\":\"" << getName()  << "\"," <<
-    "\"type\":\"" << getType()  << "\"," <<
-    "\"idRef\":"  << getIdRef() <<
+void CancelOrder::writeJson(JsonWriter& out) const {
+    out << "{" <<
+    "\"id\":"     << getId()       << "," <<
+    "\"time\":"   << getTime()     << "," <<
+    "\"name\":\"" << *getNamePtr() << "\"," <<
+    "\"type\":\"" << getType()     << "\"," <<
+    "\"idRef\":"  << getIdRef()    <<
     "}";
-    return oss.str();
 }
 
 int CancelOrder::setIdRef(int idRef) {
@@ -205,7 +223,7 @@ int CancelOrder::setIdRef(int idRef) {
 
 ModifyOrder::ModifyOrder(int id, int time, string name, int idRef, const Order& newOrder): Order(id, time, name, MODIFY), idRef(idRef), newOrder(newOrder.copy()) {}
 
-ModifyOrder::ModifyOrder(const ModifyOrder& order): Order(order), idRef(order.idRef), newOrder(order.copy()) {}
+ModifyOrder::ModifyOrder(const ModifyOrder& order): Order(order), idRef(order.idRef), newOrder((order.newOrder)?order.newOrder->copy():0) {}
 
 ModifyOrder::~ModifyOrder() {
     delete newOrder;
@@ -221,17 +239,15 @@ string ModifyOrder::read() const {
     return oss.str();
 }
 
-string ModifyOrder::getAsJson() const {
-    ostringstream oss;
-    oss << "{" <<
-    "\"id\":"       << getId()        << "," <<
-    "\"time\":"     << getTime()      << "," <<
-    "\"name\":\""   << getName()      << "\"," <<
-    "\"type\":\""   << getType()      << "\"," <<
-    "\"idRef\":"    << getIdRef()     << "," <<
-    "\"newOrder\":" << *getNewOrder() <<
+void ModifyOrder::writeJson(JsonWriter& out) const {
+    out << "{" <<
+    "\"id\":"       << getId()       << "," <<
+    "\"time\":"     << getTime()     << "," <<
+    "\"name\":\""   << *getNamePtr() << "\"," <<
+    "\"type\":\""   << getType()     << "\"," <<
+    "\"idRef\":"    << getIdRef()    << "," <<
+    "\"newOrder\":" << getNewOrder() <<
     "}";
-    return oss.str();
 }
 
 int ModifyOrder::setIdRef(int idRef) {
@@ -247,430 +263,719 @@ Order* ModifyOrder::setNewOrder(const Order& newOrder) {
 
 //### Trade class ##############################################################
 
-Trade::Trade(int time, Side side, int size, double price, const Order& bookOrder, const Order& matchOrder): time(time), side(side), size(size), price(price), bookOrder(bookOrder.copy()), matchOrder(matchOrder.copy()) {}
-
-Trade::Trade(const Trade& trade): time(trade.time), side(trade.side), size(trade.size), price(trade.price), bookOrder(trade.bookOrder->copy()), matchOrder(trade.matchOrder->copy()) {}
-
-Trade::~Trade() {
-    delete bookOrder;
-    delete matchOrder;
-}
-
-Trade* Trade::copy() const {
-    return new Trade(*this);
-}
+Trade::Trade(int time, Side side, int size, double price, int bookId, int matchId, int bookOwner, int matchOwner): time(time), size(size), price(price), bookId(bookId), matchId(matchId), bookOwner(bookOwner), matchOwner(matchOwner), side(side) {}
 
-string Trade::read() const {
+string Trade::read(string matchName) const {
     ostringstream oss;
-    oss << "trade " << matchOrder->getName() << " " << side << " " << size << " @ $" << price;
+    oss << "trade " << matchName << " " << side << " " << size << " @ $" << price;
     return oss.str();
 }
 
 string Trade::getAsJson() const {
-    ostringstream oss;
-    oss << "{" <<
-    "\"time\":"       << time                    << "," <<
-    "\"side\":\""     << side                    << "\"," <<
-    "\"size\":"       << size                    << "," <<
-    "\"price\":"      << price                   << "," <<
-    "\"bookOrder\":"  << bookOrder->getAsJson()  << "," <<
-    "\"matchOrder\":" << matchOrder->getAsJson() <<
+    JsonWriter out(256);
+    writeJson(out);
+    return out.str();
+}
+
+void Trade::writeJson(JsonWriter& out) const {
+    out << "{" <<
+    "\"time\":"       << time       << "," <<
+    "\"side\":\""     << side       << "\"," <<
+    "\"size\":"       << size       << "," <<
+    "\"price\":"      << price      << "," <<
+    "\"bookId\":"     << bookId     << "," <<
+    "\"matchId\":"    << matchId    << "," <<
+    "\"bookOwner\":"  << bookOwner  << "," <<
+    "\"matchOwner\":" << matchOwner <<
     "}";
-    return oss.str();
+}
+
+//### OrderMsg struct ##########################################################
+
+OrderMsg::OrderMsg(OrderType type, int id, int time, int owner, Side side, int size, double price): type(type), id(id), time(time), owner(owner) {
+    if (type == MARKET) {
+        market.side = side;
+        market.size = size;
+    } else {
+        limit.side = side;
+        limit.size = size;
+        limit.price = price;
+    }
+}
+
+OrderMsg::OrderMsg(OrderType type, int id, int time, int owner, int idRef, int size, double price): type(type), id(id), time(time), owner(owner) {
+    if (type == MODIFY) {
+        modify.idRef = idRef;
+        modify.size = size;
+        modify.price = price;
+    } else cancel.idRef = idRef;
 }
 
 //### LimitOrderBook class #####################################################
 
-LimitOrderBook::LimitOrderBook(): name(""), topBid(0), topAsk(0), bidTotalDepth(0), askTotalDepth(0) {}
+LimitOrderBook::LimitOrderBook(): name(""), tickSize(1), topBid(0), topAsk(0), clock(0), pool(make_shared<NodePool>(sizeof(OrderNode))), lastOwner(0), batching(false), topLevels(0), topSeq(0), bids(BID, 1, pool), asks(ASK, 1, pool) {}
 
-LimitOrderBook::LimitOrderBook(string name): name(name), topBid(0), topAsk(0), bidTotalDepth(0), askTotalDepth(0) {}
+LimitOrderBook::LimitOrderBook(string name, double tickSize, bool hugePages): name(name), tickSize(tickSize), topBid(0), topAsk(0), clock(0), pool(make_shared<NodePool>(sizeof(OrderNode), hugePages)), lastOwner(0), batching(false), topLevels(0), topSeq(0), bids(BID, tickSize, pool), asks(ASK, tickSize, pool) {}
 
-LimitOrderBook::LimitOrderBook(const LimitOrderBook& book): name(book.name), topBid(book.topBid), topAsk(book.topAsk), bidTotalDepth(book.bidTotalDepth), askTotalDepth(book.askTotalDepth), bidPrices(book.bidPrices), askPrices(book.askPrices), bidsLog(book.bidsLog), asksLog(book.asksLog), bidDepths(book.bidDepths), askDepths(book.askDepths) {
-    // TO-DO: deep copy ptr
+LimitOrderBook::LimitOrderBook(const LimitOrderBook& book): name(book.name), tickSize(book.tickSize), topBid(0), topAsk(0), clock(book.clock), pool(make_shared<NodePool>(sizeof(OrderNode), book.pool->getHugePages())), trades(book.trades), owners(book.owners), ownerIds(book.ownerIds), lastOwner(book.lastOwner), bidMktQueue(book.bidMktQueue), askMktQueue(book.askMktQueue), ordersLog(book.ordersLog), batching(false), topLevels(0), topSeq(0), bids(BID, book.tickSize, pool), asks(ASK, book.tickSize, pool) {
+    // resting orders get new nodes, relinked in priority order
+    for (auto levels : {&book.bids, &book.asks})
+        for (int i=levels->getBest(); i>=0; i=levels->next(i))
+            for (const OrderNode* n=levels->at(i)->head; n; n=n->next)
+                restOrder(OrderMsg(LIMIT, n->id, n->time, n->owner, n->side, n->size, n->price), n->size);
+    updateTopBid();
+    updateTopAsk();
 }
 
 LimitOrderBook::~LimitOrderBook() {
-    for (auto o : bidMktQueue) delete o;
-    for (auto o : askMktQueue) delete o;
-    for (auto t : trades) delete t;
-    for (auto o : ordersLog) delete o.second;
-    for (auto b : bids)
-        for (auto o : b.second) delete o;
-    for (auto a : asks)
-        for (auto o : a.second) delete o;
+    // resting order nodes are freed by the level blocks, before the pool
+}
+
+void LimitOrderBook::restOrder(const OrderMsg& msg, int size) {
+    OrderNode* node = pool->create<OrderNode>(msg, size);
+    PriceLevels* sameSide = (msg.limit.side==BID)?&bids:&asks;
+    int level = sameSide->reserve(msg.limit.price);
+    ownLevel(sameSide, level);
+    sameSide->push(level, node);
+    restingOrders.set(msg.id, node);
+}
+
+void LimitOrderBook::ownLevel(PriceLevels* levels, int idx) {
+    // copies the nodes a level borrowed from a block shared with a forked
+    // book into the pool of this book, in the same order, before the level
+    // is changed
+    PriceLevel* level = levels->at(idx);
+    if (!levels->isBorrowed(idx)) return;
+    OrderNode* prev = 0;
+    for (OrderNode* n=level->head; n; n=n->next) {
+        OrderNode* node = pool->create<OrderNode>(*n);
+        node->prev = prev;
+        if (prev) prev->next = node;
+        else level->head = node;
+        restingOrders.set(node->id, node);
+        prev = node;
+    }
+    level->tail = prev;
+    levels->setOwned(idx);
 }
 
 LimitOrderBook* LimitOrderBook::copy() const {
     return new LimitOrderBook(*this);
 }
 
-deque<Trade*> LimitOrderBook::getTrades() const {
-    deque<Trade*> tradesCopy;
-    for (auto t : trades) tradesCopy.push_back(t->copy());
-    return tradesCopy;
+LimitOrderBook* LimitOrderBook::fork() {
+    // book in the state of this one that shares its price level blocks,
+    // id index pages and order nodes, and copies only those it changes;
+    // trades and the orders log of the fork start empty. Once forked, both
+    // books may run on different threads
+    LimitOrderBook* book = new LimitOrderBook(name, tickSize, pool->getHugePages());
+    book->clock = clock;
+    book->owners = owners;
+    book->ownerIds = ownerIds;
+    book->lastOwner = lastOwner;
+    book->bidMktQueue = bidMktQueue;
+    book->askMktQueue = askMktQueue;
+    book->ordersLog.reset(ordersLog.getMode(), ordersLog.getCapacity());
+    book->bids.share(bids);
+    book->asks.share(asks);
+    book->restingOrders.share(restingOrders);
+    book->setJournaling(getJournaling());
+    book->updateTopBid();
+    book->updateTopAsk();
+    return book;
+}
+
+string LimitOrderBook::getOwnerName(int owner) const {
+    return (owner>=0 && owner<(int)owners.size())?owners[owner]:"";
 }
 
 deque<LimitOrder*> LimitOrderBook::getBidOrders(double price) const {
-    auto i = bids.find(price);
-    if (i != bids.end()) {
+    int i = bids.find(price);
+    if (i >= 0) {
         deque<LimitOrder*> orders;
-        for (auto o : i->second) orders.push_back(o->copy());
+        for (auto& o : makeLimitOrders(bids, i)) orders.push_back(o.copy());
         return orders;
     } else return {};
 }
 
 deque<LimitOrder*> LimitOrderBook::getAskOrders(double price) const {
-    auto i = asks.find(price);
-    if (i != asks.end()) {
+    int i = asks.find(price);
+    if (i >= 0) {
         deque<LimitOrder*> orders;
-        for (auto o : i->second) orders.push_back(o->copy());
+        for (auto& o : makeLimitOrders(asks, i)) orders.push_back(o.copy());
         return orders;
     } else return {};
 }
 
 deque<MarketOrder*> LimitOrderBook::getBidMktQueue() const {
     deque<MarketOrder*> bidMktQueueCopy;
-    for (auto o : bidMktQueue) bidMktQueueCopy.push_back(o->copy());
+    for (auto& m : bidMktQueue) bidMktQueueCopy.push_back(static_cast<MarketOrder*>(makeOrder(m)));
     return bidMktQueueCopy;
 }
 
 deque<MarketOrder*> LimitOrderBook::getAskMktQueue() const {
     deque<MarketOrder*> askMktQueueCopy;
-    for (auto o : askMktQueue) askMktQueueCopy.push_back(o->copy());
+    for (auto& m : askMktQueue) askMktQueueCopy.push_back(static_cast<MarketOrder*>(makeOrder(m)));
     return askMktQueueCopy;
 }
 
 map<int,Order*> LimitOrderBook::getOrdersLog() const {
     map<int,Order*> ordersLogCopy;
-    for (auto o : ordersLog) ordersLogCopy[o.first] = o.second->copy();
+    for (auto& o : ordersLog.getEntries()) ordersLogCopy[o.id] = makeOrder(o);
     return ordersLogCopy;
 }
 
+map<int,double> LimitOrderBook::getBidsLog() const {
+    map<int,double> bidsLog;
+    for (int i=bids.getBest(); i>=0; i=bids.next(i))
+        for (OrderNode* n=bids.at(i)->head; n; n=n->next) bidsLog[n->id] = n->price;
+    return bidsLog;
+}
+
+map<int,double> LimitOrderBook::getAsksLog() const {
+    map<int,double> asksLog;
+    for (int i=asks.getBest(); i>=0; i=asks.next(i))
+        for (OrderNode* n=asks.at(i)->head; n; n=n->next) asksLog[n->id] = n->price;
+    return asksLog;
+}
+
 map<double,deque<LimitOrder*>> LimitOrderBook::getBids() const {
     map<double,deque<LimitOrder*>> bidsCopy;
-    for (auto b : bids)
-        for (auto o : b.second) bidsCopy[b.first].push_back(o->copy());
+    for (int i=bids.getBest(); i>=0; i=bids.next(i))
+        for (auto& o : makeLimitOrders(bids, i)) bidsCopy[bids.getPrice(i)].push_back(o.copy());
     return bidsCopy;
 }
 
 map<double,deque<LimitOrder*>> LimitOrderBook::getAsks() const {
     map<double,deque<LimitOrder*>> asksCopy;
-    for (auto a : asks)
-        for (auto o : a.second) asksCopy[a.first].push_back(o->copy());
+    for (int i=asks.getBest(); i>=0; i=asks.next(i))
+        for (auto& o : makeLimitOrders(asks, i)) asksCopy[asks.getPrice(i)].push_back(o.copy());
     return asksCopy;
 }
 
 int LimitOrderBook::getBidDepthBetween(double price0, double price1) const{
-    int cumDepth = 0;
-    auto i0 = lower_bound(bidPrices.begin(), bidPrices.end(), price1, greater<double>());
-    auto i1 = upper_bound(bidPrices.begin(), bidPrices.end(), price0, greater<double>());
-    for (auto i=i0; i!=i1; i++) cumDepth += bidDepths.at(*i);
-    return cumDepth;
+    return bids.getDepthBetween(price0, price1);
 }
 
 int LimitOrderBook::getAskDepthBetween(double price0, double price1) const{
-    int cumDepth = 0;
-    auto i0 = lower_bound(askPrices.begin(), askPrices.end(), price0);
-    auto i1 = upper_bound(askPrices.begin(), askPrices.end(), price1);
-    for (auto i=i0; i!=i1; i++) cumDepth += askDepths.at(*i);
-    return cumDepth;
+    return asks.getDepthBetween(price0, price1);
 }
 
 map<double,int> LimitOrderBook::snapBidDepths(int bookLevels) const {
-    if (!bookLevels) bookLevels = bidPrices.size();
-    map<double,int> bidDepthsSnap;
-    for (auto p : bidPrices) {
-        bidDepthsSnap[p] = bidDepths.at(p);
-        if (bidDepthsSnap.size() == bookLevels) break;
-    }
-    return bidDepthsSnap;
+    return bids.snapDepths(bookLevels);
 }
 
 map<double,int> LimitOrderBook::snapAskDepths(int bookLevels) const {
-    if (!bookLevels) bookLevels = askPrices.size();
-    map<double,int> askDepthsSnap;
-    for (auto p : askPrices) {
-        askDepthsSnap[p] = askDepths.at(p);
-        if (askDepthsSnap.size() == bookLevels) break;
-    }
-    return askDepthsSnap;
+    return asks.snapDepths(bookLevels);
+}
+
+double LimitOrderBook::getBidPriceAtDepth(int depth) const {
+    int i = bids.findDepth(depth);
+    return (i<0)?0:bids.getPrice(i);
+}
+
+double LimitOrderBook::getAskPriceAtDepth(int depth) const {
+    int i = asks.findDepth(depth);
+    return (i<0)?0:asks.getPrice(i);
+}
+
+int LimitOrderBook::getBidIdAtDepth(int depth) const {
+    int i = bids.findDepth(depth);
+    return (i<0)?-1:bids.at(i)->head->id;
+}
+
+int LimitOrderBook::getAskIdAtDepth(int depth) const {
+    int i = asks.findDepth(depth);
+    return (i<0)?-1:asks.at(i)->head->id;
 }
 
 LimitOrder* LimitOrderBook::peekBidOrderAt(double price) const {
-    auto i = bids.find(price);
-    if (i != bids.end()) return i->second.front()->copy();
+    int i = bids.find(price);
+    if (i >= 0 && bids.at(i)->head) return makeLimitOrder(*bids.at(i)->head).copy();
     else return 0;
 }
 
 LimitOrder* LimitOrderBook::peekAskOrderAt(double price) const {
-    auto i = asks.find(price);
-    if (i != asks.end()) return i->second.front()->copy();
+    int i = asks.find(price);
+    if (i >= 0 && asks.at(i)->head) return makeLimitOrder(*asks.at(i)->head).copy();
     else return 0;
 }
 
+Order* LimitOrderBook::makeOrder(const OrderMsg& msg) const {
+    string name = getOwnerName(msg.owner);
+    switch(msg.type) {
+        case LIMIT: return new LimitOrder(msg.id, msg.time, name, msg.limit.side, msg.limit.size, msg.limit.price);
+        case MARKET: return new MarketOrder(msg.id, msg.time, name, msg.market.side, msg.market.size);
+        case CANCEL: return new CancelOrder(msg.id, msg.time, name, msg.cancel.idRef);
+        case MODIFY: return new ModifyOrder(msg.id, msg.time, name, msg.modify.idRef, LimitOrder(msg.id, msg.time, name, NULL_SIDE, msg.modify.size, msg.modify.price));
+        default: return new Order(msg.id, msg.time, name, msg.type);
+    }
+}
+
+LimitOrder LimitOrderBook::makeLimitOrder(const OrderNode& node) const {
+    return LimitOrder(node.id, node.time, getOwnerName(node.owner), node.side, node.size, node.price);
+}
+
+vector<LimitOrder> LimitOrderBook::makeLimitOrders(const PriceLevels& levels, int idx) const {
+    vector<LimitOrder> orders;
+    for (OrderNode* n=levels.at(idx)->head; n; n=n->next) orders.push_back(makeLimitOrder(*n));
+    return orders;
+}
+
 string LimitOrderBook::read() const {
     // TO-DO
     return "";
 }
 
 string LimitOrderBook::getAsJson() const {
-    ostringstream oss;
-    oss << "{";
-    oss << "\"asks\":{";
-    for (auto i=askPrices.begin(); i!=askPrices.end(); i++)
-        oss << *i << ":" << asks.at(*i) << ((i==askPrices.end()-1)?"":",");
-    oss << "},";
-    oss << "\"bids\":{";
-    for (auto i=bidPrices.begin(); i!=bidPrices.end(); i++)
-        oss << *i << ":" << bids.at(*i) << ((i==bidPrices.end()-1)?"":",");
-    oss << "}";
-    oss << "}";
-    return oss.str();
+    JsonWriter out(1<<16);
+    writeJson(out);
+    return out.str();
+}
+
+void LimitOrderBook::writeJson(JsonWriter& out) const {
+    // prices as keys to the resting orders, written from the nodes directly
+    static const string noName;
+    out << "{";
+    for (int s=0; s<2; s++) {
+        const PriceLevels& levels = (s==0)?asks:bids;
+        out << ((s==0)?"\"asks\":{":",\"bids\":{");
+        for (int i=levels.getBest(); i>=0; i=levels.next(i)) {
+            out << levels.getPrice(i) << ":[";
+            for (OrderNode* n=levels.at(i)->head; n; n=n->next) {
+                const string& name = (n->owner>=0 && n->owner<(int)owners.size())?owners[n->owner]:noName;
+                writeLimitJson(out, n->id, n->time, name, n->side, n->size, n->price);
+                if (n->next) out << ",";
+            }
+            out << "]" << ((levels.next(i)<0)?"":",");
+        }
+        out << "}";
+    }
+    out << "}";
+}
+
+int LimitOrderBook::setClock(int time) {
+    clock = time;
+    return clock;
+}
+
+int LimitOrderBook::setTopLevels(int numLevels) {
+    topLevels = max(0, min(numLevels, (int)TopOfBook::MAX_LEVELS));
+    if (topLevels) publishTop();
+    return topLevels;
+}
+
+int LimitOrderBook::registerOwner(const string& name) {
+    if (owners.size() && owners[lastOwner] == name) return lastOwner;
+    auto i = ownerIds.find(name);
+    if (i == ownerIds.end()) {
+        if (owners.size() > SHRT_MAX) throw out_of_range("LimitOrderBook::registerOwner");
+        i = ownerIds.insert(make_pair(name, (int)owners.size())).first;
+        owners.push_back(name);
+    }
+    lastOwner = i->second;
+    return lastOwner;
+}
+
+void LimitOrderBook::setOrdersLogMode(OrderLogMode mode, int capacity) {
+    ordersLog.reset(mode, capacity);
+}
+
+bool LimitOrderBook::setJournaling(bool journaling) {
+    // level changes are then drained through the levels' drainChanges
+    asks.setJournaling(journaling);
+    return bids.setJournaling(journaling);
+}
+
+void LimitOrderBook::writeCheckpoint(ostream& out, bool history) const {
+    // resting orders per side from the best level out, each level in time
+    // priority; without history, trades and the orders log are left out
+    writeCheckpointHeader(out, "OBSBOOK ", CHECKPOINT_VERSION, (history)?CHECKPOINT_HISTORY:0);
+    writeBinary(out, name);
+    writeBinary(out, tickSize);
+    writeBinary(out, clock);
+    writeBinary(out, topLevels);
+    writeBinary(out, getJournaling());
+    writeBinaryItems(out, owners);
+    writeBinary(out, lastOwner);
+    writeBinaryItems(out, bidMktQueue);
+    writeBinaryItems(out, askMktQueue);
+    for (auto levels : {&bids, &asks}) {
+        long long numOrders = 0;
+        for (int i=levels->getBest(); i>=0; i=levels->next(i)) numOrders += levels->at(i)->numOrders;
+        writeBinary(out, numOrders);
+        for (int i=levels->getBest(); i>=0; i=levels->next(i))
+            for (const OrderNode* n=levels->at(i)->head; n; n=n->next)
+                writeBinary(out, OrderMsg(LIMIT, n->id, n->time, n->owner, n->side, n->size, n->price));
+    }
+    writeBinary(out, ordersLog.getMode());
+    writeBinary(out, ordersLog.getCapacity());
+    writeBinaryItems(out, (history)?ordersLog.getEntries():vector<OrderMsg>());
+    writeBinaryItems(out, (history)?trades:vector<Trade>());
+}
+
+bool LimitOrderBook::readCheckpoint(istream& in) {
+    // replaces the whole state of the book once the checkpoint is read and
+    // checked in full, the book is left unchanged otherwise
+    int flags, clock, topLevels, lastOwner;
+    string name;
+    double tickSize;
+    bool journaling;
+    vector<string> owners;
+    deque<OrderMsg> bidMktQueue, askMktQueue;
+    vector<OrderMsg> resting, logged;
+    vector<int> ids;
+    int logMode; // an OrderLogMode, checked before the cast
+    int logCapacity;
+    vector<Trade> trades;
+    if (!readCheckpointHeader(in, "OBSBOOK ", CHECKPOINT_VERSION, flags)) return false;
+    if (!readBinary(in, name) || !readBinary(in, tickSize) || tickSize <= 0) return false;
+    if (!readBinary(in, clock) || !readBinary(in, topLevels) || !readBinary(in, journaling)) return false;
+    if (!readBinaryItems(in, owners) || !readBinary(in, lastOwner)) return false;
+    // owner ids index owners once any is registered, 0 is allowed before
+    int numOwners = max(1, (int)owners.size());
+    if (owners.size() > SHRT_MAX+1U || lastOwner < 0 || lastOwner >= numOwners) return false;
+    if (!readBinaryItems(in, bidMktQueue) || !readBinaryItems(in, askMktQueue)) return false;
+    for (Side side : {BID, ASK}) {
+        // queued market orders wait for liquidity in id order
+        deque<OrderMsg>& queue = (side==BID)?bidMktQueue:askMktQueue;
+        for (auto& msg : queue)
+            if (msg.type != MARKET || msg.market.side != side || msg.market.size <= 0 || msg.owner < 0 || msg.owner >= numOwners) return false;
+        if (!is_sorted(queue.begin(), queue.end(), [](const OrderMsg& m0, const OrderMsg& m1){return m0.id<m1.id;})) return false;
+    }
+    for (Side side : {BID, ASK}) {
+        long long numOrders;
+        OrderMsg msg;
+        if (!readBinary(in, numOrders) || numOrders < 0) return false;
+        for (long long i=0; i<numOrders; i++) {
+            if (!readBinary(in, msg)) return false;
+            if (msg.type != LIMIT || msg.limit.side != side || msg.limit.size <= 0 || msg.id < 0) return false;
+            // the tick of a price must be finite and fit a long long with room
+            if (msg.owner < 0 || msg.owner >= numOwners || !(fabs(msg.limit.price/tickSize) < 1e15)) return false;
+            resting.push_back(msg);
+            ids.push_back(msg.id);
+        }
+    }
+    sort(ids.begin(), ids.end());
+    if (adjacent_find(ids.begin(), ids.end()) != ids.end()) return false;
+    if (!readBinary(in, logMode) || !readBinary(in, logCapacity) || !readBinaryItems(in, logged)) return false;
+    if (logMode < LOG_OFF || logMode > LOG_DENSE || (logMode == LOG_RING && logCapacity <= 0)) return false;
+    if (!is_sorted(logged.begin(), logged.end(), [](const OrderMsg& m0, const OrderMsg& m1){return m0.id<m1.id;}) || (logged.size() && logged[0].id < 0)) return false;
+    if (!readBinaryItems(in, trades)) return false;
+    restingOrders.clear();
+    this->name = name;
+    this->tickSize = tickSize;
+    this->clock = clock;
+    this->lastOwner = lastOwner;
+    bids = PriceLevels(BID, tickSize, pool);
+    asks = PriceLevels(ASK, tickSize, pool);
+    for (auto& msg : resting) restOrder(msg, msg.limit.size);
+    this->owners.swap(owners);
+    ownerIds.clear();
+    for (int i=0; i<(int)this->owners.size(); i++) ownerIds[this->owners[i]] = i;
+    this->bidMktQueue.swap(bidMktQueue);
+    this->askMktQueue.swap(askMktQueue);
+    ordersLog.reset((OrderLogMode)logMode, logCapacity);
+    for (auto& msg : logged) ordersLog.log(msg);
+    this->trades.swap(trades);
+    setJournaling(journaling);
+    updateTopBid();
+    updateTopAsk();
+    setTopLevels(topLevels);
+    return true;
+}
+
+bool LimitOrderBook::saveCheckpoint(string filename, bool history) const {
+    ofstream f(filename, ios::binary);
+    writeCheckpoint(f, history);
+    f.close();
+    return !f.fail();
+}
+
+bool LimitOrderBook::loadCheckpoint(string filename) {
+    ifstream f(filename, ios::binary);
+    return f && readCheckpoint(f);
 }
 
 double LimitOrderBook::updateTopBid() {
-    topBid = (bidPrices.size()>0)?bidPrices[0]:0;
+    topBid = bids.getBestPrice();
     return topBid;
 }
 
 double LimitOrderBook::updateTopAsk() {
-    topAsk = (askPrices.size()>0)?askPrices[0]:0;
+    topAsk = asks.getBestPrice();
     return topAsk;
 }
 
-deque<double> LimitOrderBook::updateBidPrices() {
-    bidPrices.clear();
-    for (auto i=bids.begin(); i!=bids.end(); i++) bidPrices.push_back(i->first);
-    reverse(bidPrices.begin(), bidPrices.end());
-    return bidPrices;
+void LimitOrderBook::publishTop() {
+    TopOfBook top = {};
+    top.seq = ++topSeq;
+    top.clock = clock;
+    top.bidTotalDepth = bids.getTotalDepth();
+    top.askTotalDepth = asks.getTotalDepth();
+    for (int i=bids.getBest(); i>=0 && top.numBids<topLevels; i=bids.next(i)) {
+        top.bidPrices[top.numBids] = bids.getPrice(i);
+        top.bidDepths[top.numBids++] = bids.at(i)->depth;
+    }
+    for (int i=asks.getBest(); i>=0 && top.numAsks<topLevels; i=asks.next(i)) {
+        top.askPrices[top.numAsks] = asks.getPrice(i);
+        top.askDepths[top.numAsks++] = asks.at(i)->depth;
+    }
+    topOfBook.store(top);
 }
 
-deque<double> LimitOrderBook::updateAskPrices() {
-    askPrices.clear();
-    for (auto i=asks.begin(); i!=asks.end(); i++) askPrices.push_back(i->first);
-    return askPrices;
+void LimitOrderBook::process(const LimitOrder& order) {
+    processLimit(OrderMsg(LIMIT, order.getId(), order.getTime(), registerOwner(order.getName()), order.getSide(), order.getSize(), order.getPrice()));
 }
 
-void LimitOrderBook::updateBidAskPrices() {
-    updateBidPrices();
-    updateAskPrices();
-    updateTopBid();
-    updateTopAsk();
+void LimitOrderBook::process(const MarketOrder& order, bool isNew) {
+    processMarket(OrderMsg(MARKET, order.getId(), order.getTime(), registerOwner(order.getName()), order.getSide(), order.getSize()), isNew);
 }
 
-void LimitOrderBook::process(const LimitOrder& order) {
-    int id = order.getId();
-    Side side = order.getSide();
-    if (side == NULL_SIDE) return;
-    double limit = order.getPrice();
-    int unfilledSize = order.getSize();
-    int* sameSideTotalDepth = (side==BID)?&bidTotalDepth:&askTotalDepth;
-    int* oppSideTotalDepth = (side==BID)?&askTotalDepth:&bidTotalDepth;
-    deque<double>* sameSidePrices = (side==BID)?&bidPrices:&askPrices;
-    deque<double>* oppSidePrices = (side==BID)?&askPrices:&bidPrices;
-    map<double,int>* sameSideDepths = (side==BID)?&bidDepths:&askDepths;
-    map<double,int>* oppSideDepths = (side==BID)?&askDepths:&bidDepths;
-    map<double,deque<LimitOrder*>>* sameSide = (side==BID)?&bids:&asks;
-    map<double,deque<LimitOrder*>>* oppSide = (side==BID)?&asks:&bids;
-    map<int,double>* sameSideLOLog = (side==BID)?&bidsLog:&asksLog;
-    map<int,double>* oppSideLOLog = (side==BID)?&asksLog:&bidsLog;
-    ordersLog[id] = order.copy();
-    while (unfilledSize && oppSidePrices->size() && match(side, limit, oppSidePrices->front())) {
-        int* oppSideDepthAtPrice = &oppSideDepths->at(oppSidePrices->front());
-        deque<LimitOrder*>* orders = &oppSide->at(oppSidePrices->front());
-        while (unfilledSize && orders->size()) {
-            int matchedSize = min(unfilledSize, orders->front()->getSize());
-            Trade* trade = new Trade(getTradesClock(), side, matchedSize, orders->front()->getPrice(), *orders->front(), order);
-            trades.push_back(trade);
-            unfilledSize -= matchedSize;
-            orders->front()->reduceSize(matchedSize);
-            *oppSideDepthAtPrice -= matchedSize;
-            *oppSideTotalDepth -= matchedSize;
-            if (!orders->front()->getSize()) {
-                oppSideLOLog->erase(orders->front()->getId());
-                orders->pop_front();
+void LimitOrderBook::process(const CancelOrder& order) {
+    processCancel(OrderMsg(CANCEL, order.getId(), order.getTime(), registerOwner(order.getName()), order.getIdRef()));
+}
+
+void LimitOrderBook::process(const ModifyOrder& order) {
+    const Order* newOrder = order.getNewOrder();
+    if (!newOrder || newOrder->getType() != LIMIT) return;
+    const LimitOrder* limitOrder = static_cast<const LimitOrder*>(newOrder);
+    processModify(OrderMsg(MODIFY, order.getId(), order.getTime(), registerOwner(order.getName()), order.getIdRef(), limitOrder->getSize(), limitOrder->getPrice()));
+}
+
+int LimitOrderBook::matchOrder(Side side, int size, double limit, int id, int owner) {
+    // fills against the opposite side up to limit, returns the unfilled size
+    PriceLevels* oppSide = (side==BID)?&asks:&bids;
+    while (size && !oppSide->empty() && match(side, limit, oppSide->getBestPrice())) {
+        int level = oppSide->getBest();
+        ownLevel(oppSide, level);
+        PriceLevel* orders = oppSide->at(level);
+        while (size && orders->head) {
+            OrderNode* node = orders->head;
+            int matchedSize = min(size, node->size);
+            trades.push_back(Trade(clock, side, matchedSize, node->price, node->id, id, node->owner, owner));
+            size -= matchedSize;
+            node->size -= matchedSize;
+            oppSide->addDepth(level, -matchedSize);
+            if (!node->size) {
+                restingOrders.erase(node->id);
+                oppSide->unlink(level, node);
+                pool->destroy(node);
             }
         }
-        if (!orders->size()) {
-            oppSide->erase(oppSidePrices->front());
-            oppSideDepths->erase(oppSidePrices->front());
-            oppSidePrices->pop_front();
-        }
     }
-    if (unfilledSize) {
-        LimitOrder* updatedOrder = order.copy();
-        updatedOrder->setSize(unfilledSize);
-        (*sameSide)[limit].push_back(updatedOrder);
-        (*sameSideLOLog)[id] = limit;
-        (*sameSideDepths)[limit] += unfilledSize;
-        *sameSideTotalDepth += unfilledSize;
-        auto i = find(sameSidePrices->begin(), sameSidePrices->end(), limit);
-        auto c = [side,limit](double p){return (side==BID)?limit>p:limit<p;};
-        if (i == sameSidePrices->end())
-            sameSidePrices->insert(find_if(sameSidePrices->begin(), sameSidePrices->end(), c), limit);
+    return size;
+}
+
+void LimitOrderBook::processLimit(const OrderMsg& msg) {
+    int id = msg.id;
+    Side side = msg.limit.side;
+    if (side == NULL_SIDE) return;
+    double limit = msg.limit.price;
+    ordersLog.log(msg);
+    int unfilledSize = matchOrder(side, msg.limit.size, limit, id, msg.owner);
+    if (unfilledSize) restOrder(msg, unfilledSize);
+    if (!batching) {
+        updateTopBid();
+        updateTopAsk();
+        if (topLevels) publishTop();
     }
-    updateTopBid();
-    updateTopAsk();
     processMktQueue((side==BID)?ASK:BID);
 }
 
-void LimitOrderBook::process(const MarketOrder& order, bool isNew) {
-    int id = order.getId();
-    Side side = order.getSide();
+void LimitOrderBook::processMarket(const OrderMsg& msg, bool isNew) {
+    int id = msg.id;
+    Side side = msg.market.side;
     if (side == NULL_SIDE) return;
-    int unfilledSize = order.getSize();
-    int* oppSideTotalDepth = (side==BID)?&askTotalDepth:&bidTotalDepth;
-    deque<double>* oppSidePrices = (side==BID)?&askPrices:&bidPrices;
-    map<double,int>* oppSideDepths = (side==BID)?&askDepths:&bidDepths;
-    map<double,deque<LimitOrder*>>* oppSide = (side==BID)?&asks:&bids;
-    map<int,double>* oppSideLOLog = (side==BID)?&asksLog:&bidsLog;
-    ordersLog[id] = order.copy();
-    while (unfilledSize && oppSidePrices->size()) {
-        int* oppSideDepthAtPrice = &oppSideDepths->at(oppSidePrices->front());
-        deque<LimitOrder*>* orders = &oppSide->at(oppSidePrices->front());
-        while (unfilledSize && orders->size()) {
-            int matchedSize = min(unfilledSize, orders->front()->getSize());
-            Trade* trade = new Trade(getTradesClock(), side, matchedSize, orders->front()->getPrice(), *orders->front(), order);
-            trades.push_back(trade);
-            unfilledSize -= matchedSize;
-            orders->front()->reduceSize(matchedSize);
-            *oppSideDepthAtPrice -= matchedSize;
-            *oppSideTotalDepth -= matchedSize;
-            if (!orders->front()->getSize()) {
-                oppSideLOLog->erase(orders->front()->getId());
-                orders->pop_front();
-            }
-        }
-        if (!orders->size()) {
-            oppSide->erase(oppSidePrices->front());
-            oppSideDepths->erase(oppSidePrices->front());
-            oppSidePrices->pop_front();
-        }
-    }
+    double limit = (side==BID)?numeric_limits<double>::infinity():-numeric_limits<double>::infinity();
+    ordersLog.log(msg);
+    int unfilledSize = matchOrder(side, msg.market.size, limit, id, msg.owner);
     if (unfilledSize) {
-        MarketOrder* updatedOrder = order.copy();
-        updatedOrder->setSize(unfilledSize);
-        deque<MarketOrder*>* mktQueue = (side==BID)?&bidMktQueue:&askMktQueue;
-        if (isNew) mktQueue->push_back(updatedOrder);
-        else mktQueue->push_front(updatedOrder);
+        OrderMsg updatedMsg = msg;
+        updatedMsg.market.size = unfilledSize;
+        deque<OrderMsg>* mktQueue = (side==BID)?&bidMktQueue:&askMktQueue;
+        if (isNew) mktQueue->push_back(updatedMsg);
+        else mktQueue->push_front(updatedMsg);
+    }
+    if (!batching) {
+        updateTopBid();
+        updateTopAsk();
+        if (topLevels) publishTop();
     }
-    updateTopBid();
-    updateTopAsk();
 }
 
-void LimitOrderBook::process(const CancelOrder& order) {
-    int id = order.getIdRef();
-    ordersLog[id] = order.copy();
-    /**** Implementation 1 ****/
-    bool onBidBook = bidsLog.find(id)!=bidsLog.end();
-    bool onAskBook = asksLog.find(id)!=asksLog.end();
-    if (onBidBook || onAskBook) {
-        Side side = (onBidBook)?BID:ASK;
-        int* sameSideTotalDepth = (side==BID)?&bidTotalDepth:&askTotalDepth;
-        deque<double>* sameSidePrices = (side==BID)?&bidPrices:&askPrices;
-        map<double,int>* sameSideDepths = (side==BID)?&bidDepths:&askDepths;
-        map<double,deque<LimitOrder*>>* sameSide = (side==BID)?&bids:&asks;
-        map<int,double>* sameSideLOLog = (side==BID)?&bidsLog:&asksLog;
-        double limit = sameSideLOLog->at(id);
-        deque<LimitOrder*>* orders = &sameSide->at(limit);
-        auto i = lower_bound(orders->begin(), orders->end(), id, [](LimitOrder* o, int id){return o->getId()<id;});
-        if (i != orders->end() && (*i)->getId()==id) {
-            delete *i;
-            orders->erase(i);
-            sameSideLOLog->erase(id);
-            (*sameSideDepths)[limit] -= (*i)->getSize();
-            *sameSideTotalDepth -= (*i)->getSize();
-        }
-        if (!orders->size()) {
-            sameSide->erase(limit);
-            sameSideDepths->erase(limit);
-            auto i = find(sameSidePrices->begin(), sameSidePrices->end(), limit);
-            if (i != sameSidePrices->end()) sameSidePrices->erase(i);
-        }
+void LimitOrderBook::processCancel(const OrderMsg& msg) {
+    int id = msg.cancel.idRef;
+    ordersLog.log(msg);
+    OrderNode* node = restingOrders.get(id);
+    if (node) {
+        PriceLevels* sameSide = (node->side==BID)?&bids:&asks;
+        int level = sameSide->find(node->price);
+        ownLevel(sameSide, level);
+        node = restingOrders.get(id);
+        sameSide->unlink(level, node);
+        restingOrders.erase(id);
+        pool->destroy(node);
     } else {
         for (auto orders : {&bidMktQueue, &askMktQueue}) {
-            auto i = lower_bound(orders->begin(), orders->end(), id, [](MarketOrder* o, int id){return o->getId()<id;});
-            if (i != orders->end() && (*i)->getId()==id) {
-                delete *i;
+            auto i = lower_bound(orders->begin(), orders->end(), id, [](const OrderMsg& m, int id){return m.id<id;});
+            if (i != orders->end() && i->id==id) {
                 orders->erase(i);
                 break;
             }
         }
     }
-    updateTopBid();
-    updateTopAsk();
-    /**** Implementation 2 ****/
-    // auto i = ordersLog.find(id); // SLOW!
-    // if (i == ordersLog.end()) return;
-    // Order* origOrder = i->second;
-    // OrderType type = origOrder->getType();
-    // ordersLog[id] = order.copy();
-    // if (type == LIMIT) {
-    //     LimitOrder* refOrder = dynamic_cast<LimitOrder*>(origOrder);
-    //     Side side = refOrder->getSide();
-    //     double limit = refOrder->getPrice();
-    //     deque<double>* sameSidePrices = (side==BID)?&bidPrices:&askPrices;
-    //     map<double,deque<LimitOrder*>>* sameSide = (side==BID)?&bids:&asks;
-    //     map<int,double>* sameSideLOLog = (side==BID)?&bidsLog:&asksLog;
-    //     bool onBook = sameSide->find(limit)!=sameSide->end();
-    //     if (onBook) {
-    //         deque<LimitOrder*>* orders = &sameSide->at(limit);
-    //         for (auto i=orders->begin(); i!=orders->end(); i++)
-    //             if ((*i)->getId()==id) {
-    //                 delete *i;
-    //                 orders->erase(i);
-    //                 sameSideLOLog->erase(id);
-    //                 break;
-    //             }
-    //         if (!orders->size()) {
-    //             sameSide->erase(limit);
-    //             auto i = find(sameSidePrices->begin(), sameSidePrices->end(), limit);
-    //             if (i != sameSidePrices->end()) sameSidePrices->erase(i);
-    //         }
-    //     }
-    // } else if (type == MARKET) {
-    //     MarketOrder* refOrder = dynamic_cast<MarketOrder*>(origOrder);
-    //     Side side = refOrder->getSide();
-    //     deque<MarketOrder*>* orders = (side==BID)?&bidMktQueue:&askMktQueue;
-    //     for (auto i=orders->begin(); i!=orders->end(); i++)
-    //         if ((*i)->getId()==id) {
-    //             delete *i;
-    //             orders->erase(i);
-    //             break;
-    //         }
-    // }
-    // updateTopBid();
-    // updateTopAsk();
+    if (!batching) {
+        updateTopBid();
+        updateTopAsk();
+        if (topLevels) publishTop();
+    }
 }
 
-void LimitOrderBook::process(const ModifyOrder& order) {
+void LimitOrderBook::processModify(const OrderMsg& msg) {
+    int id = msg.modify.idRef;
+    ordersLog.log(msg);
+    OrderNode* node = restingOrders.get(id);
+    if (!node) return;
+    Side side = node->side;
+    int size = msg.modify.size;
+    double price = msg.modify.price;
+    PriceLevels* sameSide = (side==BID)?&bids:&asks;
+    int level = sameSide->find(node->price);
+    ownLevel(sameSide, level);
+    node = restingOrders.get(id);
+    if (size <= 0) {
+        sameSide->unlink(level, node);
+        restingOrders.erase(id);
+        pool->destroy(node);
+    } else if (sameSide->getTick(price) == sameSide->getTick(node->price)) {
+        if (size <= node->size) {
+            // size reduction in place keeps priority
+            sameSide->addDepth(level, size-node->size);
+            node->size = size;
+        } else {
+            sameSide->unlink(level, node);
+            node->time = msg.time;
+            node->size = size;
+            sameSide->push(level, node);
+        }
+    } else {
+        // price change relinks the node, matching first if it crosses
+        sameSide->unlink(level, node);
+        node->time = msg.time;
+        node->price = price;
+        node->size = matchOrder(side, size, price, id, node->owner);
+        if (node->size) {
+            level = sameSide->reserve(price);
+            ownLevel(sameSide, level);
+            sameSide->push(level, node);
+        } else {
+            restingOrders.erase(id);
+            pool->destroy(node);
+        }
+    }
+    if (!batching) {
+        updateTopBid();
+        updateTopAsk();
+        if (topLevels) publishTop();
+    }
+    processMktQueue((side==BID)?ASK:BID);
+}
 
+void LimitOrderBook::processResting(const OrderMsg& msg) {
+    // rests a limit order as is, without matching it, for feeds of a book
+    // kept elsewhere that report fills separately
+    if (msg.limit.side == NULL_SIDE || msg.limit.size <= 0) return;
+    ordersLog.log(msg);
+    restOrder(msg, msg.limit.size);
+    if (!batching) {
+        updateTopBid();
+        updateTopAsk();
+        if (topLevels) publishTop();
+    }
+}
+
+int LimitOrderBook::processExecution(int id, int size, double price, int matchId) {
+    // fills up to size of a resting order at price, as reported by such a
+    // feed, keeping its priority; the trade takes the side of the unknown
+    // incoming order, returns the size filled
+    OrderNode* node = restingOrders.get(id);
+    if (!node || size <= 0) return 0;
+    PriceLevels* sameSide = (node->side==BID)?&bids:&asks;
+    int level = sameSide->find(node->price);
+    ownLevel(sameSide, level);
+    node = restingOrders.get(id);
+    int matchedSize = min(size, node->size);
+    trades.push_back(Trade(clock, (node->side==BID)?ASK:BID, matchedSize, price, id, matchId, node->owner, 0));
+    node->size -= matchedSize;
+    sameSide->addDepth(level, -matchedSize);
+    if (!node->size) {
+        restingOrders.erase(id);
+        sameSide->unlink(level, node);
+        pool->destroy(node);
+    }
+    if (!batching) {
+        updateTopBid();
+        updateTopAsk();
+        if (topLevels) publishTop();
+    }
+    return matchedSize;
 }
 
 void LimitOrderBook::processMktQueue(Side side) {
     if (side == NULL_SIDE) return;
-    deque<double>* oppSidePrices = (side==BID)?&askPrices:&bidPrices;
-    deque<MarketOrder*>* mktQueue = (side==BID)?&bidMktQueue:&askMktQueue;
-    map<double,deque<LimitOrder*>>* sameSide = (side==BID)?&bids:&asks;
-    map<double,deque<LimitOrder*>>* oppSide = (side==BID)?&asks:&bids;
-    while (oppSidePrices->size() && mktQueue->size()) {
-        MarketOrder* topMktOrder = mktQueue->front();
+    PriceLevels* oppSide = (side==BID)?&asks:&bids;
+    deque<OrderMsg>* mktQueue = (side==BID)?&bidMktQueue:&askMktQueue;
+    while (!oppSide->empty() && mktQueue->size()) {
+        OrderMsg topMktOrder = mktQueue->front();
         mktQueue->pop_front();
-        process(*topMktOrder, false);
+        processMarket(topMktOrder, false);
     }
 }
 
 void LimitOrderBook::processOrder(const Order& order) {
     OrderType type = order.getType();
     switch(type) {
-        case LIMIT: process(*dynamic_cast<LimitOrder*>(order.copy())); break;
-        case MARKET: process(*dynamic_cast<MarketOrder*>(order.copy())); break;
-        case CANCEL: process(*dynamic_cast<CancelOrder*>(order.copy())); break;
+        case LIMIT: process(static_cast<const LimitOrder&>(order)); break;
+        case MARKET: process(static_cast<const MarketOrder&>(order)); break;
+        case CANCEL: process(static_cast<const CancelOrder&>(order)); break;
+        case MODIFY: process(static_cast<const ModifyOrder&>(order)); break;
+        default: return;
+    }
+}
+
+void LimitOrderBook::processOrder(const OrderMsg& msg) {
+    switch(msg.type) {
+        case LIMIT: processLimit(msg); break;
+        case MARKET: processMarket(msg); break;
+        case CANCEL: processCancel(msg); break;
+        case MODIFY: processModify(msg); break;
         default: return;
     }
 }
 
+void LimitOrderBook::processBatch(const OrderMsg* msgs, int numMsgs) {
+    // top of book and depth trees are refreshed once after the batch, queued
+    // market orders are still drained after each order that adds liquidity
+    batching = true;
+    bids.deferTree();
+    asks.deferTree();
+    for (const OrderMsg* msg=msgs; msg!=msgs+numMsgs; msg++) processOrder(*msg);
+    bids.syncTree();
+    asks.syncTree();
+    batching = false;
+    updateTopBid();
+    updateTopAsk();
+    if (topLevels) publishTop();
+}
+
+void LimitOrderBook::processBatch(const vector<OrderMsg>& msgs) {
+    processBatch(msgs.data(), msgs.size());
+}
+
 void LimitOrderBook::printBook(int bookLevels, int tradeLevels, bool summarizeDepth) const {
+    deque<double> bidPrices = getBidPrices();
+    deque<double> askPrices = getAskPrices();
     cout << "-------------------------------------------" << endl;
     if (summarizeDepth) {
         if (askPrices.size()) {
@@ -685,24 +990,24 @@ void LimitOrderBook::printBook(int bookLevels, int tradeLevels, bool summarizeDe
         }
         if (trades.size()) {
             cout << "-------------------TRADE-------------------" << endl;
-            for (auto i=trades.end()-1; i!=((tradeLevels>0)?trades.end()-min(tradeLevels,(int)trades.size()):trades.begin())-1; i--)
-                cout << "Trade " << trades.end()-i << " : " << (*i)->read() << endl;
+            for (int i=trades.size()-1; i>=((tradeLevels>0)?(int)trades.size()-min(tradeLevels,(int)trades.size()):0); i--)
+                cout << "Trade " << trades.size()-i << " : " << trades[i].read(getOwnerName(trades[i].getMatchOwner())) << endl;
         }
     } else {
         if (askPrices.size()) {
             for (auto i=((bookLevels>0)?askPrices.begin()+min(bookLevels,(int)askPrices.size()):askPrices.end())-1; i!=askPrices.begin()-1; i--)
-                cout << "Level " << i-askPrices.begin()+1 << " @ $" << *i << " : " << asks.at(*i) << endl;
+                cout << "Level " << i-askPrices.begin()+1 << " @ $" << *i << " : " << makeLimitOrders(asks, asks.find(*i)) << endl;
             cout << "--------------------ASK--------------------" << endl;
         }
         if (bidPrices.size()) {
             cout << "--------------------BID--------------------" << endl;
             for (auto i=bidPrices.begin(); i!=((bookLevels>0)?bidPrices.begin()+min(bookLevels,(int)bidPrices.size()):bidPrices.end()); i++)
-                cout << "Level " << i-bidPrices.begin()+1 << " @ $" << *i << " : " << bids.at(*i) << endl;
+                cout << "Level " << i-bidPrices.begin()+1 << " @ $" << *i << " : " << makeLimitOrders(bids, bids.find(*i)) << endl;
         }
         if (trades.size()) {
             cout << "-------------------TRADE-------------------" << endl;
-            for (auto i=trades.end()-1; i!=((tradeLevels>0)?trades.end()-min(tradeLevels,(int)trades.size()):trades.begin())-1; i--)
-                cout << "Trade " << trades.end()-i << " : " << *i << endl;
+            for (int i=trades.size()-1; i>=((tradeLevels>0)?(int)trades.size()-min(tradeLevels,(int)trades.size()):0); i--)
+                cout << "Trade " << trades.size()-i << " : " << trades[i] << endl;
         }
     }
     cout << "-------------------------------------------" << endl;
@@ -711,24 +1016,12 @@ void LimitOrderBook::printBook(int bookLevels, int tradeLevels, bool summarizeDe
 /**** operators ***************************************************************/
 
 ostream& operator<<(ostream& out, const Side& side) {
-    switch(side) {
-        case BID:       out << "BID"; break;
-        case ASK:       out << "ASK"; break;
-        case NULL_SIDE: out << "NULL"; break;
-        default:        out << "NULL";
-    }
+    out << getSideName(side);
     return out;
 }
 
 ostream& operator<<(ostream& out, const OrderType& type) {
-    switch(type) {
-        case LIMIT:    out << "LIMIT"; break;
-        case MARKET:   out << "MARKET"; break;
-        case CANCEL:   out << "CANCEL"; break;
-        case MODIFY:   out << "MODIFY"; break;
-        case NULL_ORD: out << "NULL"; break;
-        default:       out << "NULL";
-    }
+    out << getTypeName(type);
     return out;
 }
 
@@ -742,13 +1035,31 @@ ostream& operator<<(ostream& out, const Order& order) {
     return out;
 }
 
-ostream& operator<<(ostream& out, Trade* const trade) {
-    if (trade != 0) out << trade->getAsJson();
+ostream& operator<<(ostream& out, const Trade& trade) {
+    out << trade.getAsJson();
     return out;
 }
 
-ostream& operator<<(ostream& out, const Trade& trade) {
-    out << trade.getAsJson();
+JsonWriter& operator<<(JsonWriter& out, const Side& side) {
+    return out << getSideName(side);
+}
+
+JsonWriter& operator<<(JsonWriter& out, const OrderType& type) {
+    return out << getTypeName(type);
+}
+
+JsonWriter& operator<<(JsonWriter& out, Order* const order) {
+    if (order != 0) order->writeJson(out);
+    return out;
+}
+
+JsonWriter& operator<<(JsonWriter& out, const Order& order) {
+    order.writeJson(out);
+    return out;
+}
+
+JsonWriter& operator<<(JsonWriter& out, const Trade& trade) {
+    trade.writeJson(out);
     return out;
 }
 
@@ -4,19 +4,20 @@
 #include <vector>
 #include <deque>
 #include <map>
+#include <memory>
 #include "side.hpp"
 #include "orderType.hpp"
+#include "priceLevels.hpp"
+#include "idIndex.hpp"
+#include "nodePool.hpp"
+#include "orderLog.hpp"
+#include "seqLock.hpp"
+#include "jsonWriter.hpp"
 using namespace std;
 
-/**** global variables ********************************************************/
-
-extern int TRADES_CLOCK; // clock for trades log
-
 /**** helper functions ********************************************************/
 
 bool match(Side side, double limit, double price);
-int getTradesClock();
-int setTradesClock(int time);
 
 /**** class declarations ******************************************************/
 
@@ -36,9 +37,11 @@ public:
     int getId() const {return id;}
     int getTime() const {return time;}
     string getName() const {return name;}
+    const string* getNamePtr() const {return &name;}
     OrderType getType() const {return type;}
     virtual string read() const;
-    virtual string getAsJson() const;
+    string getAsJson() const;
+    virtual void writeJson(JsonWriter& out) const;
     /**** mutators ****/
     int setId(int id);
     int setTime(int time);
@@ -64,7 +67,7 @@ public:
     int getSize() const {return size;}
     double getPrice() const {return price;}
     string read() const;
-    string getAsJson() const;
+    void writeJson(JsonWriter& out) const;
     /**** mutators ****/
     Side setSide(Side side);
     int setSize(int size);
@@ -86,7 +89,7 @@ public:
     Side getSide() const {return side;}
     int getSize() const {return size;}
     string read() const;
-    string getAsJson() const;
+    void writeJson(JsonWriter& out) const;
     /**** mutators ****/
     Side setSide(Side side);
     int setSize(int size);
@@ -104,7 +107,7 @@ public:
     /**** accessors ****/
     int getIdRef() const {return idRef;}
     string read() const;
-    string getAsJson() const;
+    void writeJson(JsonWriter& out) const;
     /**** mutators ****/
     int setIdRef(int idRef);
 };
@@ -115,7 +118,7 @@ private:
     Order* newOrder;
 public:
     /**** constructors ****/
-    ModifyOrder(){}; ~ModifyOrder();
+    ModifyOrder(): newOrder(0){}; ~ModifyOrder();
     ModifyOrder(int id, int time, string name, int idRef, const Order& newOrder);
     ModifyOrder(const ModifyOrder& order);
     ModifyOrder* copy() const;
@@ -123,7 +126,7 @@ public:
     int getIdRef() const {return idRef;}
     Order* getNewOrder() const {return newOrder;}
     string read() const;
-    string getAsJson() const;
+    void writeJson(JsonWriter& out) const;
     /**** mutators ****/
     int setIdRef(int idRef);
     Order* setNewOrder(const Order& newOrder);
@@ -131,119 +134,215 @@ public:
     Order& operator=(const ModifyOrder& order); // TO-DO
 };
 
+struct LimitMsg {Side side; int size; double price;};
+struct MarketMsg {Side side; int size;};
+struct CancelMsg {int idRef;};
+struct ModifyMsg {int idRef; int size; double price;};
+
+struct OrderMsg {
+    // 32-byte order message tagged by type; owner is an id registered with
+    // the book, so messages are trivially copyable
+    OrderType type;
+    int id;
+    int time;
+    int owner;
+    union {
+        LimitMsg limit;
+        MarketMsg market;
+        CancelMsg cancel;
+        ModifyMsg modify;
+    };
+    OrderMsg(): type(NULL_ORD), id(0), time(0), owner(0) {}
+    OrderMsg(OrderType type, int id, int time, int owner,
+        Side side, int size, double price=0); // LIMIT, MARKET
+    OrderMsg(OrderType type, int id, int time, int owner,
+        int idRef, int size=0, double price=0); // CANCEL, MODIFY
+};
+
+struct OrderNode {
+    // resting limit order, size is the unfilled size
+    int id;
+    int time;
+    int owner;
+    Side side;
+    int size;
+    double price;
+    OrderNode* prev;
+    OrderNode* next;
+    OrderNode(const OrderMsg& msg, int size): id(msg.id), time(msg.time), owner(msg.owner), side(msg.limit.side), size(size), price(msg.limit.price), prev(0), next(0) {}
+};
+
 class Trade {
+    // 32-byte fill record: ids refer to the book and match orders, owners
+    // to the order names registered with the book, which keeps their ids
+    // within a short
 private:
     int time;
-    Side side;
     int size;
     double price;
-    Order* bookOrder;
-    Order* matchOrder;
+    int bookId, matchId;
+    short bookOwner, matchOwner;
+    Side side;
 public:
     /**** constructors ****/
-    Trade(){}; ~Trade();
+    Trade(){};
     Trade(int time, Side side, int size, double price,
-        const Order& bookOrder, const Order& matchOrder);
-    Trade(const Trade& trade);
-    Trade* copy() const;
+        int bookId, int matchId, int bookOwner=0, int matchOwner=0);
     /**** accessors ****/
     int getTime() const {return time;}
-    int getId() const {return bookOrder->getId();}
+    int getId() const {return bookId;}
+    int getBookId() const {return bookId;}
+    int getMatchId() const {return matchId;}
+    int getBookOwner() const {return bookOwner;}
+    int getMatchOwner() const {return matchOwner;}
     int getSize() const {return size;}
     double getPrice() const {return price;}
     Side getSide() const {return side;}
-    string read() const;
+    string read(string matchName="") const;
     string getAsJson() const;
-    /**** operators ****/
-    Trade& operator=(const Trade& trade); // TO-DO
+    void writeJson(JsonWriter& out) const;
+};
+
+struct TopOfBook {
+    // top levels of both sides as published by the matching thread, seq is
+    // the number of snapshots published so far
+    static const int MAX_LEVELS = 16;
+    long long seq;
+    int clock;
+    int numBids, numAsks;
+    int bidTotalDepth, askTotalDepth;
+    double bidPrices[MAX_LEVELS], askPrices[MAX_LEVELS];
+    int bidDepths[MAX_LEVELS], askDepths[MAX_LEVELS];
 };
 
 class LimitOrderBook {
 private:
     string name;
+    double tickSize;
     double topBid, topAsk;
-    int bidTotalDepth, askTotalDepth;
-    deque<Trade*> trades;
-    deque<double> bidPrices, askPrices;
-    deque<MarketOrder*> bidMktQueue, askMktQueue;
-    map<int,Order*> ordersLog;
-    map<int,double> bidsLog, asksLog;
-    map<double,int> bidDepths, askDepths;
-    map<double,deque<LimitOrder*>> bids, asks;
+    int clock; // timestamp of trades
+    shared_ptr<NodePool> pool; // resting order nodes, freed with the level blocks
+    vector<Trade> trades;
+    vector<string> owners;
+    map<string,int> ownerIds;
+    int lastOwner;
+    deque<OrderMsg> bidMktQueue, askMktQueue;
+    OrderLog<OrderMsg> ordersLog; // order history by id
+    IdIndex<OrderNode> restingOrders;
+    bool batching; // defers top of book and depth trees in processBatch
+    int topLevels; // levels per side in the published snapshot, 0 if off
+    long long topSeq;
+    SeqLock<TopOfBook> topOfBook;
+    PriceLevels bids, asks;
+    int matchOrder(Side side, int size, double limit, int id, int owner);
+    void restOrder(const OrderMsg& msg, int size);
+    void ownLevel(PriceLevels* levels, int idx);
 public:
     /**** constructors ****/
     LimitOrderBook(); ~LimitOrderBook();
-    LimitOrderBook(string name);
+    LimitOrderBook(string name, double tickSize=1, bool hugePages=false);
     LimitOrderBook(const LimitOrderBook& book);
+    LimitOrderBook& operator=(const LimitOrderBook&) = delete;
     LimitOrderBook* copy() const;
+    LimitOrderBook* fork();
     /**** accessors ****/
     string getName() const {return name;}
+    double getTickSize() const {return tickSize;}
     double getTopBid() const {return topBid;}
     double getTopAsk() const {return topAsk;}
-    deque<Trade*> getTrades() const;
-    deque<Trade*>* getTradesPtr() {return &trades;}
-    deque<double> getBidPrices() const {return bidPrices;}
-    deque<double> getAskPrices() const {return askPrices;}
-    deque<double>* getBidPricesPtr() {return &bidPrices;}
-    deque<double>* getAskPricesPtr() {return &askPrices;}
+    int getClock() const {return clock;}
+    int getTopLevels() const {return topLevels;}
+    TopOfBook getTopOfBook() const {return topOfBook.load();} // any thread
+    const SeqLock<TopOfBook>* getTopOfBookPtr() const {return &topOfBook;}
+    NodePool* getNodePoolPtr() {return pool.get();}
+    vector<Trade> getTrades() const {return trades;}
+    vector<Trade>* getTradesPtr() {return &trades;}
+    vector<string> getOwners() const {return owners;}
+    string getOwnerName(int owner) const;
+    deque<double> getBidPrices() const {return bids.getPrices();}
+    deque<double> getAskPrices() const {return asks.getPrices();}
     deque<LimitOrder*> getBidOrders(double price) const;
     deque<LimitOrder*> getAskOrders(double price) const;
     deque<MarketOrder*> getBidMktQueue() const;
     deque<MarketOrder*> getAskMktQueue() const;
     map<int,Order*> getOrdersLog() const;
-    map<int,Order*>* getOrdersLogPtr() {return &ordersLog;}
-    map<int,double> getBidsLog() const {return bidsLog;}
-    map<int,double> getAsksLog() const {return asksLog;}
-    map<double,int> getBidDepths() const {return bidDepths;}
-    map<double,int> getAskDepths() const {return askDepths;}
-    map<double,int>* getBidDepthsPtr() {return &bidDepths;}
-    map<double,int>* getAskDepthsPtr() {return &askDepths;}
+    OrderLog<OrderMsg>* getOrdersLogPtr() {return &ordersLog;}
+    const OrderMsg* getLoggedOrder(int id) const {return ordersLog.get(id);}
+    map<int,double> getBidsLog() const;
+    map<int,double> getAsksLog() const;
+    map<double,int> getBidDepths() const {return bids.snapDepths();}
+    map<double,int> getAskDepths() const {return asks.snapDepths();}
     map<double,deque<LimitOrder*>> getBids() const;
     map<double,deque<LimitOrder*>> getAsks() const;
-    map<double,deque<LimitOrder*>>* getBidsPtr() {return &bids;}
-    map<double,deque<LimitOrder*>>* getAsksPtr() {return &asks;}
-    int getBidTotalDepth() const {return bidTotalDepth;}
-    int getAskTotalDepth() const {return askTotalDepth;}
-    int getBidDepthAt(double price) const
-        {return (bidDepths.count(price))?bidDepths.at(price):0;}
-    int getAskDepthAt(double price) const
-        {return (askDepths.count(price))?askDepths.at(price):0;}
+    bool getJournaling() const {return bids.getJournaling();}
+    PriceLevels* getBidLevelsPtr() {return &bids;}
+    PriceLevels* getAskLevelsPtr() {return &asks;}
+    int getBidTotalDepth() const {return bids.getTotalDepth();}
+    int getAskTotalDepth() const {return asks.getTotalDepth();}
+    int getBidDepthAt(double price) const {return bids.getDepthAt(price);}
+    int getAskDepthAt(double price) const {return asks.getDepthAt(price);}
     int getBidDepthBetween(double price0, double price1) const;
     int getAskDepthBetween(double price0, double price1) const;
     map<double,int> snapBidDepths(int bookLevels=0) const;
     map<double,int> snapAskDepths(int bookLevels=0) const;
+    double getBidPriceAtDepth(int depth) const; // depth summed from the top
+    double getAskPriceAtDepth(int depth) const;
+    int getBidIdAtDepth(int depth) const; // first order at that price
+    int getAskIdAtDepth(int depth) const;
     LimitOrder* peekBidOrderAt(double price) const;
     LimitOrder* peekAskOrderAt(double price) const;
+    Order* makeOrder(const OrderMsg& msg) const;
+    LimitOrder makeLimitOrder(const OrderNode& node) const;
+    vector<LimitOrder> makeLimitOrders(const PriceLevels& levels, int idx) const;
     string read() const;
     string getAsJson() const;
+    void writeJson(JsonWriter& out) const;
+    /**** mutators ****/
+    int setClock(int time);
+    int setTopLevels(int numLevels);
+    int registerOwner(const string& name);
+    void setOrdersLogMode(OrderLogMode mode, int capacity=0);
+    bool setJournaling(bool journaling);
+    /**** checkpoint ****/
+    static const int CHECKPOINT_VERSION = 1;
+    void writeCheckpoint(ostream& out, bool history=true) const;
+    bool readCheckpoint(istream& in);
+    bool saveCheckpoint(string filename, bool history=true) const;
+    bool loadCheckpoint(string filename);
     /**** main ****/
     double updateTopBid();
     double updateTopAsk();
-    deque<double> updateBidPrices();
-    deque<double> updateAskPrices();
-    void updateBidAskPrices();
+    void publishTop();
     void process(const LimitOrder& order);
     void process(const MarketOrder& order, bool isNew=true);
     void process(const CancelOrder& order);
     void process(const ModifyOrder& order);
+    void processLimit(const OrderMsg& msg);
+    void processMarket(const OrderMsg& msg, bool isNew=true);
+    void processCancel(const OrderMsg& msg);
+    void processModify(const OrderMsg& msg);
+    void processResting(const OrderMsg& msg);
+    int processExecution(int id, int size, double price, int matchId);
     void processMktQueue(Side side);
     void processOrder(const Order& order);
+    void processOrder(const OrderMsg& msg);
+    void processBatch(const OrderMsg* msgs, int numMsgs);
+    void processBatch(const vector<OrderMsg>& msgs);
     void printBook(int bookLevels=0, int tradeLevels=0,
         bool summarizeDepth=true) const;
 };
 
-class Exchange {
-private:
-    vector<LimitOrderBook*> books;
-};
-
 /**** operators ***************************************************************/
 
 ostream& operator<<(ostream& out, const Side& side);
 ostream& operator<<(ostream& out, const OrderType& type);
 ostream& operator<<(ostream& out, Order* const order);
 ostream& operator<<(ostream& out, const Order& order);
-ostream& operator<<(ostream& out, Trade* const trade);
 ostream& operator<<(ostream& out, const Trade& trade);
+JsonWriter& operator<<(JsonWriter& out, const Side& side);
+JsonWriter& operator<<(JsonWriter& out, const OrderType& type);
+JsonWriter& operator<<(JsonWriter& out, Order* const order);
+JsonWriter& operator<<(JsonWriter& out, const Order& order);
+JsonWriter& operator<<(JsonWriter& out, const Trade& trade);
 
 #endif
@@ -1,58 +1,63 @@
 #ifndef ORDERBOOKSTATS_CPP
 #define ORDERBOOKSTATS_CPP
+#include <cassert>
 #include <vector>
 #include <deque>
 #include <map>
 #include "orderBook.hpp"
+#include "binaryLog.hpp"
+#include "timeSeries.hpp"
 #include "orderBookStats.hpp"
 using namespace std;
 
 /**** class functions *********************************************************/
 //### OrderBookStats class ###################################################
 
-OrderBookStats::OrderBookStats(const map<int,map<double,int>>& bidDepthsLog, const map<int,map<double,int>>& askDepthsLog, const deque<Trade*>& trades): bidDepthsLog(bidDepthsLog), askDepthsLog(askDepthsLog) {
-    for (auto t : trades) this->trades.push_back(t->copy());
-}
+OrderBookStats::OrderBookStats(const map<int,map<double,int>>& bidDepthsLog, const map<int,map<double,int>>& askDepthsLog, const vector<Trade>& trades): trades(trades), bidDepthsLog(bidDepthsLog), askDepthsLog(askDepthsLog) {}
 
-OrderBookStats::OrderBookStats(const OrderBookStats& obs): bidDepthsLog(obs.bidDepthsLog), askDepthsLog(obs.askDepthsLog) {
-    for (auto t : obs.trades) this->trades.push_back(t->copy());
+OrderBookStats::OrderBookStats(const OrderBookStats& obs): trades(obs.trades), bidDepthsLog(obs.bidDepthsLog), askDepthsLog(obs.askDepthsLog) {
+    if (obs.depthLog.isOpen()) depthLog.open(obs.depthLog.getFilename());
+    if (obs.tradeLog.isOpen()) tradeLog.open(obs.tradeLog.getFilename());
 }
 
 OrderBookStats::OrderBookStats(string depthsFile, string tradesFile) {
-    // TO-DO
-}
-
-OrderBookStats::~OrderBookStats() {
-    for (auto t : trades) delete t;
+    // maps the binary logs written by DepthLogFile/TradeLogFile, their columns
+    // are read in place; loadDepthsLog/loadTrades copy them into the logs
+    depthLog.open(depthsFile);
+    if (tradesFile != "") tradeLog.open(tradesFile);
 }
 
 void OrderBookStats::initStats() {
+    if (bidDepthsLog.empty() && depthLog.isOpen()) {
+        // top of book straight from the mapped columns, none without levels
+        int L = depthLog.getNumLevels();
+        if (L <= 0) return;
+        Span<int> times = depthLog.getTimes();
+        Span<double> bidPrices = depthLog.getBidPrices(), askPrices = depthLog.getAskPrices();
+        Span<int> bidSizes = depthLog.getBidSizes(), askSizes = depthLog.getAskSizes();
+        reserveStats(times.size());
+        for (size_t s=0; s<times.size(); s++)
+            updateStats(times[s], bidPrices[s*L], askPrices[s*L], bidSizes[s*L], askSizes[s*L]);
+        return;
+    }
     vector<int> timeB, timeA;
     for (auto b : bidDepthsLog) timeB.push_back(b.first);
     for (auto a : askDepthsLog) timeA.push_back(a.first);
     assert(timeB == timeA);
-    depthsLogTime = timeB;
-    for (auto t : depthsLogTime) {
+    reserveStats(timeB.size());
+    for (auto t : timeB) {
         bidCumDepthsLog[t] = askCumDepthsLog[t] = {};
         map<double,int>* bidDepths = &bidDepthsLog.at(t);
         map<double,int>* askDepths = &askDepthsLog.at(t);
+        if (bidDepths->empty() || askDepths->empty()) continue;
         double B = bidDepths->rbegin()->first, A = askDepths->begin()->first;
         int Sb = bidDepths->rbegin()->second, Sa = askDepths->begin()->second;
-        topBids[t] = B;
-        topAsks[t] = A;
-        topBidSizes[t] = Sb;
-        topBidSizes[t] = Sa;
-        midPrices[t] = (A+B)/2;
-        microPrices[t] = (A*Sb+B*Sa)/(Sa+Sb);
-        imbalances[t] = (Sb-Sa)/(Sa+Sb);
-        spreads[t] = A-B;
+        updateStats(t, B, A, Sb, Sa);
         // TO-DO: bidCumDepthsLog, askCumDepthsLog
     }
 }
 
 void OrderBookStats::clearStats() {
-    for (auto t : trades) delete t;
-    depthsLogTime.clear();
     trades.clear();
     topBidSizes.clear();
     topAskSizes.clear();
@@ -66,13 +71,69 @@ void OrderBookStats::clearStats() {
     askDepthsLog.clear();
     bidCumDepthsLog.clear();
     askCumDepthsLog.clear();
+    depthLog.close();
+    tradeLog.close();
+}
+
+void OrderBookStats::reserveStats(int numSnaps) {
+    for (auto series : {&topBidSizes, &topAskSizes}) series->reserve(numSnaps);
+    for (auto series : {&topBids, &topAsks, &midPrices, &microPrices, &imbalances, &spreads}) series->reserve(numSnaps);
+}
+
+void OrderBookStats::updateStats(int t, double B, double A, int Sb, int Sa) {
+    // O(1) when t is later than every time so far; snaps with an empty side
+    // are skipped, their micro-price and imbalance are undefined
+    if (Sb <= 0 || Sa <= 0) return;
+    topBids[t] = B;
+    topAsks[t] = A;
+    topBidSizes[t] = Sb;
+    topAskSizes[t] = Sa;
+    midPrices[t] = (A+B)/2;
+    microPrices[t] = (A*Sb+B*Sa)/(Sa+Sb);
+    imbalances[t] = (double)(Sb-Sa)/(Sa+Sb);
+    spreads[t] = A-B;
+}
+
+void OrderBookStats::updateStats(int t, const LimitOrderBook& ob) {
+    // top of book of a live book, e.g. at every snap of a simulation
+    double B = ob.getTopBid(), A = ob.getTopAsk();
+    updateStats(t, B, A, ob.getBidDepthAt(B), ob.getAskDepthAt(A));
+}
+
+void OrderBookStats::loadDepthsLog() {
+    for (long long s=0; s<depthLog.getNumSnaps(); s++) {
+        int t = depthLog.getTimes()[s];
+        bidDepthsLog[t] = depthLog.getBidDepths(s);
+        askDepthsLog[t] = depthLog.getAskDepths(s);
+    }
+}
+
+void OrderBookStats::loadTrades() {
+    vector<Trade> t = tradeLog.getTrades();
+    trades.insert(trades.end(), t.begin(), t.end());
+}
+
+void OrderBookStats::merge(const map<int,map<double,int>>& bidDepthsLog, const map<int,map<double,int>>& askDepthsLog, const vector<Trade>& trades, int timeOffset) {
+    // appends another run shifted by timeOffset, call initStats afterwards
+    for (auto& b : bidDepthsLog) this->bidDepthsLog[b.first+timeOffset] = b.second;
+    for (auto& a : askDepthsLog) this->askDepthsLog[a.first+timeOffset] = a.second;
+    this->trades.reserve(this->trades.size()+trades.size());
+    for (auto& t : trades)
+        this->trades.push_back(Trade(t.getTime()+timeOffset, t.getSide(), t.getSize(), t.getPrice(), t.getBookId(), t.getMatchId(), t.getBookOwner(), t.getMatchOwner()));
+}
+
+void OrderBookStats::merge(const OrderBookStats& obs, int timeOffset) {
+    merge(obs.bidDepthsLog, obs.askDepthsLog, obs.trades, timeOffset);
 }
 
 map<double,double> OrderBookStats::calcAvgBookDepths(vector<double> band, int aggInterval) {
-    double n = depthsLogTime.size();
+    // needs the depth logs, online stats alone only give zeros
+    const vector<int>& times = midPrices.getTimes();
+    double n = times.size();
     map<double,double> avgBookDepths;
     for (auto p : band) avgBookDepths[p] = 0;
-    for (auto t : depthsLogTime) {
+    if (bidDepthsLog.empty()) return avgBookDepths;
+    for (auto t : times) {
         if (t % aggInterval == 0) {
             int M = midPrices.at(t);
             map<double,int>* bidDepths = &bidDepthsLog.at(t);
@@ -4,44 +4,58 @@
 #include <deque>
 #include <map>
 #include "orderBook.hpp"
+#include "binaryLog.hpp"
+#include "timeSeries.hpp"
 using namespace std;
 
 /**** class declarations ******************************************************/
 
 class OrderBookStats {
 private:
-    vector<int> depthsLogTime;
-    deque<Trade*> trades;
-    map<int,int> topBidSizes, topAskSizes;
-    map<int,double> topBids, topAsks, midPrices, microPrices, imbalances, spreads;
+    vector<Trade> trades;
+    TimeSeries<int> topBidSizes, topAskSizes;
+    TimeSeries<double> topBids, topAsks, midPrices, microPrices, imbalances, spreads;
     map<int,map<double,int>> bidDepthsLog, askDepthsLog;
     map<int,map<double,int>> bidCumDepthsLog, askCumDepthsLog;
+    DepthLogFile depthLog; // mapped binary logs, see OrderBookStats(depthsFile)
+    TradeLogFile tradeLog;
 public:
     /**** constructors ****/
-    OrderBookStats(){}; ~OrderBookStats();
+    OrderBookStats(){}; ~OrderBookStats(){};
     OrderBookStats(const map<int,map<double,int>>& bidDepthsLog,
                    const map<int,map<double,int>>& askDepthsLog,
-                   const deque<Trade*>& trades={});
+                   const vector<Trade>& trades={});
     OrderBookStats(const OrderBookStats& obs);
     OrderBookStats(string depthsFile, string tradesFile="");
     /**** accessors ****/
-    deque<Trade*> getTrades() const {return trades;}
-    deque<Trade*>* getTradesPtr() {return &trades;}
-    map<int,int>* getTopBidSizesPtr() {return &topBidSizes;}
-    map<int,int>* getTopAskSizesPtr() {return &topAskSizes;}
-    map<int,double>* getTopBidsPtr() {return &topBids;}
-    map<int,double>* getTopAsksPtr() {return &topAsks;}
-    map<int,double>* getMidPricesPtr() {return &midPrices;}
-    map<int,double>* getMicroPricesPtr() {return &microPrices;}
-    map<int,double>* getImbalancesPtr() {return &imbalances;}
-    map<int,double>* getSpreadsPtr() {return &spreads;}
+    vector<Trade> getTrades() const {return trades;}
+    vector<Trade>* getTradesPtr() {return &trades;}
+    TimeSeries<int>* getTopBidSizesPtr() {return &topBidSizes;}
+    TimeSeries<int>* getTopAskSizesPtr() {return &topAskSizes;}
+    TimeSeries<double>* getTopBidsPtr() {return &topBids;}
+    TimeSeries<double>* getTopAsksPtr() {return &topAsks;}
+    TimeSeries<double>* getMidPricesPtr() {return &midPrices;}
+    TimeSeries<double>* getMicroPricesPtr() {return &microPrices;}
+    TimeSeries<double>* getImbalancesPtr() {return &imbalances;}
+    TimeSeries<double>* getSpreadsPtr() {return &spreads;}
     map<int,map<double,int>> getBidDepthsLog() const {return bidDepthsLog;}
     map<int,map<double,int>> getAskDepthsLog() const {return askDepthsLog;}
     map<int,map<double,int>>* getBidDepthsLogPtr() {return &bidDepthsLog;}
     map<int,map<double,int>>* getAskDepthsLogPtr() {return &askDepthsLog;}
+    DepthLogFile* getDepthLogPtr() {return &depthLog;}
+    TradeLogFile* getTradeLogPtr() {return &tradeLog;}
     /**** main ****/
     void initStats();
     void clearStats();
+    void reserveStats(int numSnaps);
+    void updateStats(int t, double B, double A, int Sb, int Sa);
+    void updateStats(int t, const LimitOrderBook& ob);
+    void loadDepthsLog();
+    void loadTrades();
+    void merge(const map<int,map<double,int>>& bidDepthsLog,
+               const map<int,map<double,int>>& askDepthsLog,
+               const vector<Trade>& trades={}, int timeOffset=0);
+    void merge(const OrderBookStats& obs, int timeOffset=0);
     map<double,double> calcAvgBookDepths(vector<double> band, int aggInterval=1);
     map<int,double> calcBidPriceSignal(int maxSize=0);
     map<int,double> calcAskPriceSignal(int maxSize=0);
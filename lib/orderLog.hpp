@@ -0,0 +1,78 @@
+#ifndef ORDERLOG_HPP
+#define ORDERLOG_HPP
+#include <algorithm>
+#include <vector>
+using namespace std;
+
+enum OrderLogMode {LOG_OFF, LOG_RING, LOG_DENSE};
+
+/**** class declarations ******************************************************/
+
+template <typename T>
+class OrderLog {
+    // history of messages keyed by their non-negative id member: LOG_RING
+    // keeps the last capacity ids in slot id%capacity and never grows,
+    // LOG_DENSE keeps every id from the first logged one in a flat vector;
+    // both give O(1) lookups, empty slots have id -1
+private:
+    OrderLogMode mode;
+    int capacity;
+    int baseId; // id of entries[0] in LOG_DENSE
+    int size;
+    vector<T> entries;
+    static T emptyEntry() {T entry; entry.id = -1; return entry;}
+public:
+    /**** constructors ****/
+    OrderLog(OrderLogMode mode=LOG_DENSE, int capacity=0) {reset(mode, capacity);}
+    /**** accessors ****/
+    OrderLogMode getMode() const {return mode;}
+    int getCapacity() const {return capacity;}
+    int getSize() const {return size;}
+    const T* get(int id) const {
+        if (id < 0) return 0;
+        const T* entry = 0;
+        if (mode == LOG_RING && capacity > 0) entry = &entries[id%capacity];
+        else if (mode == LOG_DENSE && id >= baseId && id-baseId < (int)entries.size())
+            entry = &entries[id-baseId];
+        return (entry && entry->id==id)?entry:0;
+    }
+    vector<T> getEntries() const {
+        // logged messages in id order
+        vector<T> logged;
+        logged.reserve(size);
+        for (auto& e : entries) if (e.id >= 0) logged.push_back(e);
+        if (mode == LOG_RING)
+            sort(logged.begin(), logged.end(), [](const T& a, const T& b){return a.id<b.id;});
+        return logged;
+    }
+    /**** mutators ****/
+    void log(const T& msg) {
+        int id = msg.id;
+        if (id < 0) return;
+        T* entry = 0;
+        if (mode == LOG_RING && capacity > 0) entry = &entries[id%capacity];
+        else if (mode == LOG_DENSE) {
+            if (entries.empty()) baseId = id;
+            if (id < baseId) {
+                entries.insert(entries.begin(), baseId-id, emptyEntry());
+                baseId = id;
+            }
+            if (id-baseId >= (int)entries.size())
+                entries.resize(id-baseId+1, emptyEntry());
+            entry = &entries[id-baseId];
+        }
+        if (!entry) return;
+        if (entry->id < 0) size++;
+        *entry = msg;
+    }
+    void reset(OrderLogMode mode, int capacity=0) {
+        this->mode = mode;
+        this->capacity = (mode==LOG_RING)?max(capacity, 0):0;
+        baseId = size = 0;
+        vector<T>().swap(entries);
+        if (mode == LOG_RING) entries.assign(this->capacity, emptyEntry());
+    }
+    void clear() {reset(mode, capacity);}
+};
+
+#endif
@@ -0,0 +1,472 @@
+#ifndef PRICELEVELS_CPP
+#define PRICELEVELS_CPP
+#include <cmath>
+#include <algorithm>
+#include <vector>
+#include <deque>
+#include <map>
+#include "side.hpp"
+#include "orderBook.hpp"
+#include "priceLevels.hpp"
+using namespace std;
+
+/**** class functions *********************************************************/
+//### PriceLevels class ########################################################
+
+LevelBlock PriceLevels::emptyBlock(2); // never written, so always copied first
+
+PriceLevels::PriceLevels(): side(NULL_SIDE), tickSize(1), baseTick(0), best(-1), numLevels(0), totalDepth(0), numTicks(0), farDepth(0), treeSynced(true), journaling(false) {}
+
+PriceLevels::PriceLevels(Side side, double tickSize, shared_ptr<NodePool> pool): side(side), tickSize(tickSize), pool(pool), baseTick(0), best(-1), numLevels(0), totalDepth(0), numTicks(0), farDepth(0), treeSynced(true), journaling(false) {}
+
+PriceLevels::PriceLevels(const PriceLevels& levels): side(levels.side), tickSize(levels.tickSize), pool(levels.pool), baseTick(levels.baseTick), best(levels.best), numLevels(levels.numLevels), totalDepth(levels.totalDepth), numTicks(levels.numTicks), farDepth(levels.farDepth), blocks(levels.blocks), bitmap(levels.bitmap), tree(levels.tree), farBlocks(levels.farBlocks), freeFar(levels.freeFar), emptyFar(levels.emptyFar), farIndex(levels.farIndex), treeSynced(levels.treeSynced), journaling(levels.journaling), journal(levels.journal) {
+    // blocks are shared, and the nodes of their levels with them
+    for (auto block : blocks) holdBlock(block);
+    for (auto& far : farBlocks)
+        if (far.block) holdBlock(far.block);
+}
+
+PriceLevels& PriceLevels::operator=(PriceLevels levels) {
+    swap(side, levels.side);
+    swap(tickSize, levels.tickSize);
+    pool.swap(levels.pool);
+    swap(baseTick, levels.baseTick);
+    swap(best, levels.best);
+    swap(numLevels, levels.numLevels);
+    swap(totalDepth, levels.totalDepth);
+    swap(numTicks, levels.numTicks);
+    swap(farDepth, levels.farDepth);
+    blocks.swap(levels.blocks);
+    bitmap.swap(levels.bitmap);
+    tree.swap(levels.tree);
+    farBlocks.swap(levels.farBlocks);
+    freeFar.swap(levels.freeFar);
+    emptyFar.swap(levels.emptyFar);
+    farIndex.swap(levels.farIndex);
+    swap(treeSynced, levels.treeSynced);
+    swap(journaling, levels.journaling);
+    journal.swap(levels.journal);
+    return *this;
+}
+
+PriceLevels::~PriceLevels() {
+    releaseBlocks();
+}
+
+void PriceLevels::unshareBlock(LevelBlock*& block) {
+    // the copy borrows the nodes of the non-empty levels from their owner
+    LevelBlock* copy = new LevelBlock(1, pool);
+    for (int i=0; i<LevelBlock::SIZE; i++) {
+        copy->levels[i] = block->levels[i];
+        if (!block->levels[i].head) continue;
+        LevelBlock* origin = (block->origins[i])?block->origins[i]:block;
+        origin->levelRefs[i].fetch_add(1, memory_order_relaxed);
+        origin->refs.fetch_add(1, memory_order_relaxed);
+        copy->origins[i] = origin;
+    }
+    releaseBlock(block);
+    block = copy;
+}
+
+void PriceLevels::holdBlock(LevelBlock* block) {
+    if (block == &emptyBlock) return;
+    block->holders.fetch_add(1, memory_order_relaxed);
+    block->refs.fetch_add(1, memory_order_relaxed);
+}
+
+void PriceLevels::releaseBlock(LevelBlock* block) {
+    // the last holder frees the nodes of the levels nothing borrows and
+    // returns the levels the block borrowed
+    if (block == &emptyBlock) return;
+    if (block->holders.fetch_sub(1, memory_order_acq_rel) == 1)
+        for (int i=0; i<LevelBlock::SIZE; i++) {
+            if (block->origins[i]) releaseLevel(block->origins[i], i);
+            else if (block->levelRefs[i].fetch_sub(1, memory_order_acq_rel) == 1) freeNodes(block->pool.get(), block->levels[i].head);
+        }
+    unrefBlock(block);
+}
+
+void PriceLevels::releaseLevel(LevelBlock* block, int i) {
+    // a borrower of level i is done with its nodes
+    if (block->levelRefs[i].fetch_sub(1, memory_order_acq_rel) == 1) freeNodes(block->pool.get(), block->levels[i].head);
+    unrefBlock(block);
+}
+
+void PriceLevels::unrefBlock(LevelBlock* block) {
+    if (block->refs.fetch_sub(1, memory_order_acq_rel) == 1) delete block;
+}
+
+void PriceLevels::freeNodes(NodePool* nodePool, OrderNode* head) {
+    // nodes of a pool of another book go back to it as remote nodes
+    if (!nodePool) return;
+    for (OrderNode* n=head; n;) {
+        OrderNode* next = n->next;
+        if (nodePool == pool.get()) nodePool->deallocate(n);
+        else nodePool->deallocateRemote(n);
+        n = next;
+    }
+}
+
+void PriceLevels::releaseBlocks() {
+    for (auto block : blocks) releaseBlock(block);
+    for (auto& far : farBlocks)
+        if (far.block) releaseBlock(far.block);
+    blocks.clear();
+    farBlocks.clear();
+    freeFar.clear();
+    emptyFar.clear();
+    farIndex.clear();
+}
+
+long long PriceLevels::getTick(double price) const {
+    return llround(price/tickSize);
+}
+
+int PriceLevels::findTick(long long tick) const {
+    // index of the level at tick, -1 if outside the window and far blocks
+    long long i = tick-baseTick;
+    if (i>=0 && i<numTicks) return i;
+    auto far = farIndex.find(tick>>6);
+    return (far==farIndex.end())?-1:FAR_INDEX+far->second*64+(tick&63);
+}
+
+int PriceLevels::find(double price) const {
+    return findTick(getTick(price));
+}
+
+int PriceLevels::nextBelow(int idx) const {
+    if (idx <= 0) return -1;
+    int w = (idx-1)>>6;
+    unsigned long long bits = bitmap[w] & (~0ULL>>(63-((idx-1)&63)));
+    while (!bits) {
+        if (--w < 0) return -1;
+        bits = bitmap[w];
+    }
+    return (w<<6)+63-__builtin_clzll(bits);
+}
+
+int PriceLevels::nextAbove(int idx) const {
+    if (idx+1 >= numTicks) return -1;
+    int w = (idx+1)>>6;
+    unsigned long long bits = bitmap[w] & (~0ULL<<((idx+1)&63));
+    while (!bits) {
+        if (++w >= (int)bitmap.size()) return -1;
+        bits = bitmap[w];
+    }
+    return (w<<6)+__builtin_ctzll(bits);
+}
+
+int PriceLevels::nextFar(long long tick) const {
+    // first non-empty far level worse than tick
+    if (side == BID) {
+        auto i = farIndex.upper_bound(tick>>6);
+        while (i != farIndex.begin()) {
+            i--;
+            unsigned long long bits = farBlocks[i->second].bits;
+            if (i->first == (tick>>6)) bits &= (1ULL<<(tick&63))-1;
+            if (bits) return FAR_INDEX+i->second*64+63-__builtin_clzll(bits);
+        }
+    } else {
+        for (auto i=farIndex.lower_bound(tick>>6); i!=farIndex.end(); i++) {
+            unsigned long long bits = farBlocks[i->second].bits;
+            if (i->first == (tick>>6)) bits &= (~0ULL<<(tick&63))<<1;
+            if (bits) return FAR_INDEX+i->second*64+__builtin_ctzll(bits);
+        }
+    }
+    return -1;
+}
+
+int PriceLevels::next(int idx) const {
+    // the window first, then the far levels
+    if (idx >= FAR_INDEX) return nextFar(getTickAt(idx));
+    int i = (side==BID)?nextBelow(idx):nextAbove(idx);
+    return (i<0 && farIndex.size())?firstFar():i;
+}
+
+int PriceLevels::getDepthAt(double price) const {
+    int i = find(price);
+    return (i<0)?0:level(i).depth;
+}
+
+int PriceLevels::getDepthBetween(double price0, double price1) const {
+    long long tick0 = getTick(price0), tick1 = getTick(price1);
+    long long i0 = max(tick0-baseTick, 0LL);
+    long long i1 = min(tick1-baseTick, (long long)numTicks-1);
+    int cumDepth = 0;
+    if (i0 <= i1) {
+        if (treeSynced) cumDepth = treeSum(i1)-((i0)?treeSum(i0-1):0);
+        else for (long long i=i0; i<=i1; i++) cumDepth += level(i).depth;
+    }
+    if (!farDepth) return cumDepth;
+    for (auto i=farIndex.lower_bound(tick0>>6); i!=farIndex.end() && i->first<=(tick1>>6); i++)
+        for (unsigned long long bits=farBlocks[i->second].bits; bits; bits&=bits-1) {
+            long long tick = i->first*64+__builtin_ctzll(bits);
+            if (tick>=tick0 && tick<=tick1) cumDepth += farBlocks[i->second].block->levels[tick&63].depth;
+        }
+    return cumDepth;
+}
+
+int PriceLevels::findDepth(int depth) const {
+    // level at which the depth summed from the best level reaches depth
+    if (depth <= 0 || depth > totalDepth) return -1;
+    int windowDepth = totalDepth-farDepth;
+    int i = best, cumDepth = 0;
+    if (treeSynced) {
+        if (depth <= windowDepth) return (side==BID)?treeSearch(windowDepth-depth+1):treeSearch(depth);
+        i = firstFar();
+        cumDepth = windowDepth;
+    }
+    for (cumDepth+=level(i).depth; cumDepth<depth; cumDepth+=level(i).depth) i = next(i);
+    return i;
+}
+
+void PriceLevels::treeAdd(int idx, int size) {
+    for (int i=idx+1; i<(int)tree.size(); i+=i&-i) tree[i] += size;
+}
+
+int PriceLevels::treeSum(int idx) const {
+    // depth of levels 0..idx
+    int cumDepth = 0;
+    for (int i=idx+1; i>0; i-=i&-i) cumDepth += tree[i];
+    return cumDepth;
+}
+
+int PriceLevels::treeSearch(int depth) const {
+    // smallest idx with treeSum(idx) >= depth, numTicks is a power of 2
+    int i = 0;
+    for (int step=numTicks; step; step>>=1)
+        if (i+step < (int)tree.size() && tree[i+step] < depth) {
+            i += step;
+            depth -= tree[i];
+        }
+    return i;
+}
+
+deque<double> PriceLevels::getPrices(int numLevels) const {
+    deque<double> prices;
+    for (int i=best; i>=0; i=next(i)) {
+        prices.push_back(getPrice(i));
+        if ((int)prices.size() == numLevels) break;
+    }
+    return prices;
+}
+
+map<double,int> PriceLevels::snapDepths(int numLevels) const {
+    map<double,int> depthsSnap;
+    for (int i=best; i>=0; i=next(i)) {
+        depthsSnap[getPrice(i)] = level(i).depth;
+        if ((int)depthsSnap.size() == numLevels) break;
+    }
+    return depthsSnap;
+}
+
+int PriceLevels::grow(long long tick) {
+    // a tick outside the window: the window grows to cover it while it
+    // spans at most MAX_TICKS/2 ticks, else it moves to a better price or
+    // to the best level, and ticks far from both go to far blocks
+    long long lo = tick, hi = tick;
+    if (numTicks) {
+        lo = min(lo, baseTick);
+        hi = max(hi, baseTick+numTicks-1);
+    }
+    long long bestTick = (best<0)?tick:getTickAt(best);
+    if (hi-lo < MAX_TICKS/2) {
+        int size = 1024;
+        while (size < 2*(hi-lo+1)) size *= 2;
+        moveWindow((lo+(hi-lo)/2-size/2)&~63LL, size);
+    } else if (best<0 || isBetter(tick, bestTick)) moveWindow((tick-MAX_TICKS/2)&~63LL, MAX_TICKS);
+    else if (llabs(tick-bestTick) < MAX_TICKS/2-64) moveWindow((bestTick-MAX_TICKS/2)&~63LL, MAX_TICKS);
+    else {
+        releaseEmptyFar();
+        int slot = addFar(tick>>6, &emptyBlock, 0);
+        return FAR_INDEX+slot*64+(tick&63);
+    }
+    return tick-baseTick;
+}
+
+void PriceLevels::moveWindow(long long newBaseTick, int size) {
+    // blocks keep their levels: those leaving the window become far blocks
+    // and far blocks inside it come back
+    releaseEmptyFar();
+    long long first = newBaseTick>>6, last = first+size/64;
+    vector<LevelBlock*> newBlocks(size/64, &emptyBlock);
+    vector<unsigned long long> newBitmap(size/64, 0);
+    for (int b=0; b<(int)blocks.size(); b++) {
+        long long key = (baseTick>>6)+b;
+        if (key>=first && key<last) {
+            newBlocks[key-first] = blocks[b];
+            newBitmap[key-first] = bitmap[b];
+        } else if (bitmap[b]) addFar(key, blocks[b], bitmap[b]);
+        else releaseBlock(blocks[b]);
+    }
+    for (auto i=farIndex.lower_bound(first); i!=farIndex.end() && i->first<last;) {
+        FarBlock& far = farBlocks[i->second];
+        newBlocks[i->first-first] = far.block;
+        newBitmap[i->first-first] = far.bits;
+        far.block = 0;
+        freeFar.push_back(i->second);
+        i = farIndex.erase(i);
+    }
+    blocks.swap(newBlocks);
+    bitmap.swap(newBitmap);
+    baseTick = newBaseTick;
+    numTicks = size;
+    farDepth = 0;
+    for (auto& far : farIndex)
+        for (unsigned long long bits=farBlocks[far.second].bits; bits; bits&=bits-1)
+            farDepth += farBlocks[far.second].block->levels[__builtin_ctzll(bits)].depth;
+    best = (side==BID)?nextBelow(numTicks):nextAbove(-1);
+    if (best < 0) best = firstFar();
+    if (treeSynced) buildTree();
+}
+
+int PriceLevels::addFar(long long key, LevelBlock* block, unsigned long long bits) {
+    int slot;
+    if (freeFar.size()) {
+        slot = freeFar.back();
+        freeFar.pop_back();
+    } else {
+        slot = farBlocks.size();
+        farBlocks.push_back(FarBlock());
+    }
+    farBlocks[slot] = {key, bits, block};
+    farIndex[key] = slot;
+    return slot;
+}
+
+void PriceLevels::releaseEmptyFar() {
+    // far blocks are released here rather than when emptied, as callers may
+    // still point into the level they just emptied
+    for (int slot : emptyFar) {
+        FarBlock& far = farBlocks[slot];
+        if (!far.block || far.bits) continue;
+        farIndex.erase(far.key);
+        releaseBlock(far.block);
+        far.block = 0;
+        freeFar.push_back(slot);
+    }
+    emptyFar.clear();
+}
+
+void PriceLevels::buildTree() {
+    int size = numTicks;
+    tree.assign(size+1, 0);
+    for (int i=1; i<=size; i++) {
+        tree[i] += level(i-1).depth;
+        if (i+(i&-i) <= size) tree[i+(i&-i)] += tree[i];
+    }
+}
+
+int PriceLevels::reserve(double price) {
+    long long tick = getTick(price);
+    int i = findTick(tick);
+    return (i<0)?grow(tick):i;
+}
+
+void PriceLevels::addDepth(int idx, int size) {
+    if (journaling) journal.push_back(make_pair(getTickAt(idx), level(idx).depth));
+    at(idx)->depth += size;
+    totalDepth += size;
+    if (idx >= FAR_INDEX) farDepth += size;
+    else if (treeSynced) treeAdd(idx, size);
+}
+
+void PriceLevels::push(int idx, OrderNode* node) {
+    PriceLevel* level = at(idx);
+    node->prev = level->tail;
+    node->next = 0;
+    if (level->tail) level->tail->next = node;
+    else level->head = node;
+    level->tail = node;
+    level->numOrders++;
+    addDepth(idx, node->size);
+    activate(idx);
+}
+
+void PriceLevels::unlink(int idx, OrderNode* node) {
+    PriceLevel* level = at(idx);
+    if (node->prev) node->prev->next = node->next;
+    else level->head = node->next;
+    if (node->next) node->next->prev = node->prev;
+    else level->tail = node->prev;
+    node->prev = node->next = 0;
+    level->numOrders--;
+    addDepth(idx, -node->size);
+    if (!level->numOrders) deactivate(idx);
+}
+
+void PriceLevels::setOwned(int idx) {
+    // the nodes of the level were copied into the pool of its block
+    at(idx);
+    LevelBlock* block = blockAt(idx);
+    LevelBlock* origin = block->origins[idx&63];
+    block->origins[idx&63] = 0;
+    if (origin) releaseLevel(origin, idx&63);
+}
+
+void PriceLevels::share(const PriceLevels& levels) {
+    // this side in the state of levels, sharing its blocks, while the
+    // levels it writes keep coming from its own pool
+    shared_ptr<NodePool> pool = this->pool;
+    *this = levels;
+    this->pool = pool;
+}
+
+void PriceLevels::activate(int idx) {
+    unsigned long long& bits = bitsAt(idx);
+    if (bits & (1ULL<<(idx&63))) return;
+    bits |= 1ULL<<(idx&63);
+    numLevels++;
+    if (best<0 || isBetter(getTickAt(idx), getTickAt(best))) best = idx;
+}
+
+void PriceLevels::deactivate(int idx) {
+    unsigned long long& bits = bitsAt(idx);
+    if (!(bits & (1ULL<<(idx&63)))) return;
+    bits &= ~(1ULL<<(idx&63));
+    numLevels--;
+    if (!bits && idx >= FAR_INDEX) emptyFar.push_back((idx-FAR_INDEX)>>6);
+    if (idx == best) best = next(idx);
+}
+
+void PriceLevels::deferTree() {
+    treeSynced = false;
+}
+
+void PriceLevels::syncTree() {
+    if (treeSynced) return;
+    buildTree();
+    treeSynced = true;
+}
+
+bool PriceLevels::setJournaling(bool journaling) {
+    this->journaling = journaling;
+    journal.clear();
+    return this->journaling;
+}
+
+void PriceLevels::drainChanges(vector<LevelUpdate>& updates) {
+    // one update per changed level, in tick order; levels changed and
+    // restored since the last drain are skipped
+    stable_sort(journal.begin(), journal.end(), [](const pair<long long,int>& a, const pair<long long,int>& b){return a.first<b.first;});
+    for (int i=0; i<(int)journal.size(); i++) {
+        if (i && journal[i].first == journal[i-1].first) continue;
+        int idx = findTick(journal[i].first);
+        int depth = (idx>=0)?level(idx).depth:0;
+        if (depth != journal[i].second) updates.push_back({journal[i].first*tickSize, journal[i].second, depth});
+    }
+    journal.clear();
+}
+
+void PriceLevels::clear() {
+    releaseBlocks();
+    numTicks = 0;
+    bitmap.clear();
+    tree.clear();
+    baseTick = 0;
+    best = -1;
+    numLevels = totalDepth = farDepth = 0;
+    journal.clear();
+}
+
+#endif
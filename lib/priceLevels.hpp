@@ -0,0 +1,166 @@
+#ifndef PRICELEVELS_HPP
+#define PRICELEVELS_HPP
+#include <atomic>
+#include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include "side.hpp"
+#include "nodePool.hpp"
+using namespace std;
+
+struct OrderNode;
+
+/**** class declarations ******************************************************/
+
+struct PriceLevel {
+    int depth;
+    int numOrders;
+    OrderNode* head; // time priority: head is matched first
+    OrderNode* tail;
+    PriceLevel(): depth(0), numOrders(0), head(0), tail(0) {}
+};
+
+struct LevelBlock {
+    // SIZE consecutive levels, shared by forked books until one of them
+    // writes to it; the nodes of a level are allocated from the pool of its
+    // block, unless origins points to the block it borrowed them from when
+    // copied. The nodes of a level are freed once no book holds the block
+    // and no copy borrows them, the block once it has no references left
+    static const int SIZE = 64;
+    atomic<int> refs; // holders and borrowing levels
+    atomic<int> holders; // books holding the block
+    atomic<int> levelRefs[SIZE]; // borrowers of each level, plus one while held
+    shared_ptr<NodePool> pool;
+    LevelBlock* origins[SIZE];
+    PriceLevel levels[SIZE];
+    explicit LevelBlock(int refs=1, shared_ptr<NodePool> pool=nullptr): refs(refs), holders(refs), pool(pool), origins() {
+        for (auto& r : levelRefs) r.store(1, memory_order_relaxed);
+    }
+    LevelBlock(const LevelBlock&) = delete;
+    LevelBlock& operator=(const LevelBlock&) = delete;
+};
+
+struct FarBlock {
+    // block of levels outside the window, bits marks its non-empty levels
+    long long key; // first tick/SIZE, blocks are aligned to SIZE ticks
+    unsigned long long bits;
+    LevelBlock* block; // 0 if the slot is free
+};
+
+struct LevelUpdate {
+    // depth of a level before and after the changes since the last drain,
+    // prevDepth 0 adds the level and depth 0 removes it
+    double price;
+    int prevDepth;
+    int depth;
+};
+
+class PriceLevels {
+    // levels of one side in blocks of SIZE ticks: a window of at most
+    // MAX_TICKS ticks around the best price is indexed densely, with a
+    // bitmap and a depth tree, and blocks are only allocated once written;
+    // levels outside the window are kept in far blocks by tick and indexed
+    // from FAR_INDEX, all of them worse than any level in the window.
+    // Blocks written are first copied unless only this side holds them and
+    // they come from its pool
+private:
+    static const int MAX_TICKS = 1<<16;
+    static const int FAR_INDEX = 1<<30;
+    static LevelBlock emptyBlock; // stands for blocks not yet written
+    Side side;
+    double tickSize;
+    shared_ptr<NodePool> pool; // of the blocks written, 0 if nodes are not pooled
+    long long baseTick; // tick of level 0, a multiple of SIZE
+    int best; // index of best level, -1 if empty
+    int numLevels, totalDepth;
+    int numTicks; // levels in the window
+    int farDepth; // depth of the far levels
+    vector<LevelBlock*> blocks; // the window, tick-indexed
+    vector<unsigned long long> bitmap; // non-empty levels, a word per block
+    vector<int> tree; // Fenwick tree of level depths in the window, 1-based
+    vector<FarBlock> farBlocks; // slots of far blocks
+    vector<int> freeFar; // free slots
+    vector<int> emptyFar; // slots emptied since the last release
+    map<long long,int> farIndex; // slot of each far block by key
+    bool treeSynced; // false while tree updates are deferred
+    bool journaling; // record level changes for drainChanges
+    vector<pair<long long,int>> journal; // tick and depth before each change
+    LevelBlock* blockAt(int idx) const {return (idx<FAR_INDEX)?blocks[idx>>6]:farBlocks[(idx-FAR_INDEX)>>6].block;}
+    const PriceLevel& level(int idx) const {return blockAt(idx)->levels[idx&63];}
+    unsigned long long& bitsAt(int idx) {return (idx<FAR_INDEX)?bitmap[idx>>6]:farBlocks[(idx-FAR_INDEX)>>6].bits;}
+    bool isBetter(long long tick0, long long tick1) const {return (side==BID)?tick0>tick1:tick0<tick1;}
+    void unshareBlock(LevelBlock*& block);
+    void holdBlock(LevelBlock* block);
+    void releaseBlock(LevelBlock* block);
+    void releaseLevel(LevelBlock* block, int i);
+    void unrefBlock(LevelBlock* block);
+    void freeNodes(NodePool* nodePool, OrderNode* head);
+    void releaseBlocks();
+    int findTick(long long tick) const;
+    int grow(long long tick);
+    void moveWindow(long long newBaseTick, int size);
+    int addFar(long long key, LevelBlock* block, unsigned long long bits);
+    void releaseEmptyFar();
+    void buildTree();
+    void treeAdd(int idx, int size);
+    int treeSum(int idx) const;
+    int treeSearch(int depth) const;
+    int nextBelow(int idx) const;
+    int nextAbove(int idx) const;
+    int nextFar(long long tick) const;
+    int firstFar() const {return nextFar((side==BID)?baseTick:baseTick+numTicks-1);}
+public:
+    /**** constructors ****/
+    PriceLevels();
+    PriceLevels(Side side, double tickSize=1, shared_ptr<NodePool> pool=nullptr);
+    PriceLevels(const PriceLevels& levels);
+    PriceLevels& operator=(PriceLevels levels);
+    ~PriceLevels();
+    /**** accessors ****/
+    Side getSide() const {return side;}
+    double getTickSize() const {return tickSize;}
+    int getNumLevels() const {return numLevels;}
+    int getTotalDepth() const {return totalDepth;}
+    bool empty() const {return best<0;}
+    int getBest() const {return best;}
+    double getBestPrice() const {return (best<0)?0:getPrice(best);}
+    double getPrice(int idx) const {return getTickAt(idx)*tickSize;}
+    long long getTick(double price) const;
+    long long getTickAt(int idx) const {return (idx<FAR_INDEX)?baseTick+idx:farBlocks[(idx-FAR_INDEX)>>6].key*LevelBlock::SIZE+(idx&63);}
+    int find(double price) const;
+    int next(int idx) const;
+    PriceLevel* at(int idx) {
+        // write access, copies the block first if it is shared or foreign
+        LevelBlock*& block = (idx<FAR_INDEX)?blocks[idx>>6]:farBlocks[(idx-FAR_INDEX)>>6].block;
+        if (block->refs.load(memory_order_acquire) > 1 || block->pool != pool) unshareBlock(block);
+        return &block->levels[idx&63];
+    }
+    const PriceLevel* at(int idx) const {return &level(idx);}
+    bool isBorrowed(int idx) const {return blockAt(idx)->origins[idx&63];}
+    int getWindowSize() const {return numTicks;}
+    int getNumFarBlocks() const {return farIndex.size();}
+    int getDepth(int idx) const {return level(idx).depth;}
+    int getDepthAt(double price) const;
+    int getDepthBetween(double price0, double price1) const;
+    int findDepth(int depth) const;
+    deque<double> getPrices(int numLevels=0) const;
+    map<double,int> snapDepths(int numLevels=0) const;
+    bool getJournaling() const {return journaling;}
+    /**** mutators ****/
+    int reserve(double price);
+    void addDepth(int idx, int size);
+    void push(int idx, OrderNode* node);
+    void unlink(int idx, OrderNode* node);
+    void setOwned(int idx);
+    void share(const PriceLevels& levels);
+    void activate(int idx);
+    void deactivate(int idx);
+    void deferTree();
+    void syncTree();
+    bool setJournaling(bool journaling);
+    void drainChanges(vector<LevelUpdate>& updates);
+    void clear();
+};
+
+#endif
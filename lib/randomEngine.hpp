@@ -0,0 +1,117 @@
+#ifndef RANDOMENGINE_HPP
+#define RANDOMENGINE_HPP
+#include <cmath>
+using namespace std;
+
+/**** class declarations ******************************************************/
+
+class RandomEngine {
+    // per-instance xoshiro256** stream with the draws of util.cpp, seeded
+    // explicitly so every simulation is reproducible from its seed; jump()
+    // advances 2^128 draws, so split() streams never overlap
+private:
+    unsigned long long seed;
+    unsigned long long state[4];
+    double spareNormal; // second Box-Muller variate
+    bool hasSpareNormal;
+    static unsigned long long rotl(unsigned long long x, int k) {return (x<<k)|(x>>(64-k));}
+public:
+    typedef unsigned long long result_type;
+    /**** constructors ****/
+    RandomEngine(unsigned long long seed=0) {setSeed(seed);}
+    /**** accessors ****/
+    unsigned long long getSeed() const {return seed;}
+    const unsigned long long* getState() const {return state;}
+    double getSpareNormal() const {return spareNormal;}
+    bool getHasSpareNormal() const {return hasSpareNormal;}
+    static constexpr unsigned long long min() {return 0;}
+    static constexpr unsigned long long max() {return ~0ULL;}
+    /**** mutators ****/
+    unsigned long long setSeed(unsigned long long seed) {
+        // state from splitmix64, as recommended for xoshiro
+        this->seed = seed;
+        for (auto& s : state) {
+            unsigned long long z = (seed += 0x9e3779b97f4a7c15ULL);
+            z = (z^(z>>30))*0xbf58476d1ce4e5b9ULL;
+            z = (z^(z>>27))*0x94d049bb133111ebULL;
+            s = z^(z>>31);
+        }
+        spareNormal = 0;
+        hasSpareNormal = false;
+        return this->seed;
+    }
+    void setState(unsigned long long seed, const unsigned long long* state, bool hasSpareNormal=false, double spareNormal=0) {
+        // resumes a stream saved from the accessors, e.g. from a checkpoint
+        this->seed = seed;
+        for (int i=0; i<4; i++) this->state[i] = state[i];
+        this->hasSpareNormal = hasSpareNormal;
+        this->spareNormal = spareNormal;
+    }
+    void jump() {
+        const unsigned long long JUMP[] = {0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL};
+        unsigned long long s[4] = {0, 0, 0, 0};
+        for (auto j : JUMP)
+            for (int b=0; b<64; b++) {
+                if (j & (1ULL<<b))
+                    for (int i=0; i<4; i++) s[i] ^= state[i];
+                (*this)();
+            }
+        for (int i=0; i<4; i++) state[i] = s[i];
+        hasSpareNormal = false;
+    }
+    RandomEngine split() {
+        // returns the current stream and moves this one 2^128 draws ahead
+        RandomEngine rng(*this);
+        jump();
+        return rng;
+    }
+    /**** main ****/
+    unsigned long long operator()() {
+        unsigned long long result = rotl(state[1]*5, 7)*9;
+        unsigned long long t = state[1]<<17;
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = rotl(state[3], 45);
+        return result;
+    }
+    double uniform(double min=0, double max=1) {return min+(max-min)*(((*this)()>>11)*(1.0/(1ULL<<53)));} // [min,max)
+    int uniformInt(double min, double max) {return floor(uniform(min,max+1));}
+    double exponential(double lambda) {return -log(1-uniform())/lambda;} // lambda: intensity
+    double normal(double mu=0, double sig=1) {
+        if (hasSpareNormal) {
+            hasSpareNormal = false;
+            return mu+sig*spareNormal;
+        }
+        double r = sqrt(-2*log(1-uniform())), theta = 2*M_PI*uniform();
+        spareNormal = r*sin(theta);
+        hasSpareNormal = true;
+        return mu+sig*r*cos(theta);
+    }
+    /**** bulk ****/
+    // the generator runs serially into out, the transforms run as separate
+    // branch-free loops the compiler can vectorize
+    void fillUniform(double* out, int n, double min=0, double max=1) {
+        for (int i=0; i<n; i++) out[i] = (double)((*this)()>>11);
+        double scale = (max-min)*(1.0/(1ULL<<53));
+        for (int i=0; i<n; i++) out[i] = min+scale*out[i];
+    }
+    void fillExponential(double* out, int n, double lambda) {
+        fillUniform(out, n);
+        for (int i=0; i<n; i++) out[i] = -log(1-out[i])/lambda;
+    }
+    void fillNormal(double* out, int n, double mu=0, double sig=1) {
+        // Box-Muller on pairs of uniforms, both variates are kept
+        fillUniform(out, n&~1);
+        for (int i=0; i+1<n; i+=2) {
+            double r = sqrt(-2*log(1-out[i])), theta = 2*M_PI*out[i+1];
+            out[i] = mu+sig*r*cos(theta);
+            out[i+1] = mu+sig*r*sin(theta);
+        }
+        if (n&1) out[n-1] = normal(mu, sig);
+    }
+};
+
+#endif
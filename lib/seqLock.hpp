@@ -0,0 +1,53 @@
+#ifndef SEQLOCK_HPP
+#define SEQLOCK_HPP
+#include <cstring>
+#include <atomic>
+using namespace std;
+
+/**** class declarations ******************************************************/
+
+template <typename T>
+class SeqLock {
+    // single-writer seqlock for a trivially copyable T: the writer makes seq
+    // odd, copies, makes it even again; readers retry if seq was odd or moved
+    // during their copy, so they never block the writer. The value is kept
+    // in atomic words to stay free of data races
+private:
+    static const int NUM_WORDS = (sizeof(T)+7)/8;
+    atomic<unsigned long long> seq;
+    atomic<unsigned long long> words[NUM_WORDS];
+public:
+    /**** constructors ****/
+    SeqLock(): seq(0) {
+        for (auto& w : words) w.store(0, memory_order_relaxed);
+    }
+    SeqLock(const SeqLock&) = delete;
+    SeqLock& operator=(const SeqLock&) = delete;
+    /**** accessors ****/
+    unsigned long long getSeq() const {return seq.load(memory_order_acquire);}
+    bool tryLoad(T& value) const {
+        unsigned long long buf[NUM_WORDS];
+        unsigned long long s0 = seq.load(memory_order_acquire);
+        if (s0&1) return false;
+        for (int i=0; i<NUM_WORDS; i++) buf[i] = words[i].load(memory_order_acquire);
+        if (seq.load(memory_order_relaxed) != s0) return false;
+        memcpy(&value, buf, sizeof(T));
+        return true;
+    }
+    T load() const {
+        T value;
+        while (!tryLoad(value));
+        return value;
+    }
+    /**** mutators ****/
+    void store(const T& value) {
+        unsigned long long buf[NUM_WORDS] = {};
+        memcpy(buf, &value, sizeof(T));
+        unsigned long long s = seq.load(memory_order_relaxed);
+        seq.store(s+1, memory_order_relaxed);
+        for (int i=0; i<NUM_WORDS; i++) words[i].store(buf[i], memory_order_release);
+        seq.store(s+2, memory_order_release);
+    }
+};
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef SPAN_HPP
+#define SPAN_HPP
+#include <cstddef>
+using namespace std;
+
+/**** class declarations ******************************************************/
+
+template <typename T>
+class Span {
+    // non-owning view of n contiguous values, e.g. a column of a mapped
+    // file; it is only valid as long as the memory it points to
+private:
+    const T* first;
+    size_t n;
+public:
+    /**** constructors ****/
+    Span(): first(0), n(0) {}
+    Span(const T* first, size_t n): first(first), n(n) {}
+    /**** accessors ****/
+    const T* data() const {return first;}
+    size_t size() const {return n;}
+    bool empty() const {return !n;}
+    const T* begin() const {return first;}
+    const T* end() const {return first+n;}
+    const T& operator[](size_t i) const {return first[i];}
+    const T& front() const {return first[0];}
+    const T& back() const {return first[n-1];}
+    Span<T> subspan(size_t offset, size_t count) const {return Span<T>(first+offset, count);}
+};
+
+#endif
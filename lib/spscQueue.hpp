@@ -0,0 +1,63 @@
+#ifndef SPSCQUEUE_HPP
+#define SPSCQUEUE_HPP
+#include <cstddef>
+#include <atomic>
+#include <vector>
+using namespace std;
+
+/**** class declarations ******************************************************/
+
+template <typename T>
+class SpscQueue {
+    // bounded lock-free ring for one producer and one consumer thread; each
+    // side caches the other's index and the indices sit on separate cache
+    // lines, so an uncontended push or pop touches no shared line
+private:
+    static const int CACHE_LINE = 64;
+    vector<T> slots;
+    size_t mask;
+    char pad0[CACHE_LINE];
+    atomic<size_t> head; // next slot to pop, written by the consumer
+    size_t tailCache;
+    char pad1[CACHE_LINE];
+    atomic<size_t> tail; // next slot to push, written by the producer
+    size_t headCache;
+    char pad2[CACHE_LINE];
+public:
+    /**** constructors ****/
+    SpscQueue(size_t capacity=1024): head(0), tailCache(0), tail(0), headCache(0) {
+        size_t size = 1;
+        while (size < capacity) size *= 2;
+        slots.resize(size);
+        mask = size-1;
+    }
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+    /**** accessors ****/
+    size_t getCapacity() const {return mask+1;}
+    size_t getSize() const {return tail.load(memory_order_acquire)-head.load(memory_order_acquire);}
+    bool empty() const {return !getSize();}
+    /**** main ****/
+    bool push(const T& item) {
+        size_t t = tail.load(memory_order_relaxed);
+        if (t-headCache > mask) {
+            headCache = head.load(memory_order_acquire);
+            if (t-headCache > mask) return false;
+        }
+        slots[t&mask] = item;
+        tail.store(t+1, memory_order_release);
+        return true;
+    }
+    bool pop(T& item) {
+        size_t h = head.load(memory_order_relaxed);
+        if (h == tailCache) {
+            tailCache = tail.load(memory_order_acquire);
+            if (h == tailCache) return false;
+        }
+        item = slots[h&mask];
+        head.store(h+1, memory_order_release);
+        return true;
+    }
+};
+
+#endif
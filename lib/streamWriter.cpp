@@ -0,0 +1,109 @@
+#ifndef STREAMWRITER_CPP
+#define STREAMWRITER_CPP
+#include <fstream>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include "side.hpp"
+#include "orderBook.hpp"
+#include "priceLevels.hpp"
+#include "spscQueue.hpp"
+#include "jsonWriter.hpp"
+#include "csvWriter.hpp"
+#include "streamWriter.hpp"
+using namespace std;
+
+/**** class functions *********************************************************/
+//### StreamWriter class #######################################################
+
+StreamWriter::StreamWriter(string tradesFile, string depthsFile, int bookLevels, int queueSize): tradesFile(tradesFile), depthsFile(depthsFile), bookLevels(bookLevels), tradesQueue(queueSize), depthsQueue(queueSize), running(false), numTrades(0), numSnapshots(0) {
+    open();
+}
+
+StreamWriter::~StreamWriter() {
+    close();
+}
+
+void StreamWriter::run() {
+    // same csv as the ZI printers; rows are buffered and written once a
+    // buffer fills or the rings run dry
+    JsonWriter bt(1<<16), bd(1<<16);
+    bt << CsvWriter::getTradesHeader();
+    bd << CsvWriter::getDepthsHeader(bookLevels);
+    bool rowOpen = false;
+    Trade t;
+    DepthRecord d;
+    while (true) {
+        // read before draining, so everything pushed before close() is written
+        bool stopping = !running.load(memory_order_acquire);
+        long long n = 0;
+        for (; n<4096 && tradesQueue.pop(t); n++) CsvWriter::writeTradeRow(bt, t);
+        for (int i=0; i<4096 && depthsQueue.pop(d); i++, n++) {
+            if (d.side == NULL_SIDE) {
+                if (rowOpen) bd << "\n";
+                bd << d.time;
+                rowOpen = true;
+            } else bd << "," << d.price << "," << d.size;
+        }
+        if (bt.size() >= (1<<16) || !n) bt.writeTo(ft);
+        if (bd.size() >= (1<<16) || !n) bd.writeTo(fd);
+        if (n) continue;
+        else if (stopping) break;
+        else this_thread::sleep_for(chrono::microseconds(100));
+    }
+    if (rowOpen) fd << "\n";
+    ft.close();
+    fd.close();
+}
+
+bool StreamWriter::open() {
+    // false if either file cannot be opened, nothing is written then
+    if (running.load()) return true;
+    ft.clear();
+    fd.clear();
+    ft.open(tradesFile, ios::binary);
+    fd.open(depthsFile, ios::binary);
+    if (!ft || !fd) {
+        ft.close();
+        fd.close();
+        return false;
+    }
+    running.store(true, memory_order_release);
+    writer = thread(&StreamWriter::run, this);
+    return true;
+}
+
+void StreamWriter::push(const DepthRecord& record) {
+    while (!depthsQueue.push(record)) this_thread::yield();
+}
+
+void StreamWriter::writeTrade(const Trade& trade) {
+    while (!tradesQueue.push(trade)) this_thread::yield();
+    numTrades++;
+}
+
+void StreamWriter::writeTrades(const vector<Trade>& trades, int begin) {
+    for (int i=begin; i<(int)trades.size(); i++) writeTrade(trades[i]);
+}
+
+void StreamWriter::writeDepths(int time, const PriceLevels& bids, const PriceLevels& asks) {
+    // bids from the best price down, then asks from the best price up
+    int n = 0;
+    push({time, NULL_SIDE, 0, 0});
+    for (int i=bids.getBest(); i>=0 && (!bookLevels || n<bookLevels); i=bids.next(i), n++)
+        push({time, BID, bids.getDepth(i), bids.getPrice(i)});
+    n = 0;
+    for (int i=asks.getBest(); i>=0 && (!bookLevels || n<bookLevels); i=asks.next(i), n++)
+        push({time, ASK, asks.getDepth(i), asks.getPrice(i)});
+    numSnapshots++;
+}
+
+bool StreamWriter::close() {
+    // false if the writer was not open or a write failed
+    if (!running.load()) return false;
+    running.store(false, memory_order_release);
+    if (writer.joinable()) writer.join();
+    return !ft.fail() && !fd.fail();
+}
+
+#endif
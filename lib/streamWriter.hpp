@@ -0,0 +1,62 @@
+#ifndef STREAMWRITER_HPP
+#define STREAMWRITER_HPP
+#include <fstream>
+#include <atomic>
+#include <thread>
+#include "side.hpp"
+#include "orderBook.hpp"
+#include "priceLevels.hpp"
+#include "spscQueue.hpp"
+using namespace std;
+
+/**** class declarations ******************************************************/
+
+struct DepthRecord {
+    // one level of a depth snapshot, a NULL_SIDE record starts the row of
+    // the snapshot taken at time
+    int time;
+    Side side;
+    int size;
+    double price;
+};
+
+class StreamWriter {
+    // writes trades and depth snapshots to csv on a background thread while
+    // the simulation runs; records go through SPSC rings, so memory is
+    // bounded by the ring sizes and the producer only waits if a ring fills;
+    // the files are opened before the thread starts, so a writer that could
+    // not open them is never open
+private:
+    string tradesFile, depthsFile;
+    ofstream ft, fd; // written by the writer thread only
+    int bookLevels;
+    SpscQueue<Trade> tradesQueue;
+    SpscQueue<DepthRecord> depthsQueue;
+    atomic<bool> running;
+    long long numTrades, numSnapshots; // pushed by the producer
+    thread writer;
+    void run();
+    void push(const DepthRecord& record);
+public:
+    /**** constructors ****/
+    StreamWriter(string tradesFile, string depthsFile, int bookLevels=0,
+        int queueSize=1<<16); // open() the files
+    StreamWriter(const StreamWriter&) = delete;
+    StreamWriter& operator=(const StreamWriter&) = delete;
+    ~StreamWriter();
+    /**** accessors ****/
+    string getTradesFile() const {return tradesFile;}
+    string getDepthsFile() const {return depthsFile;}
+    int getBookLevels() const {return bookLevels;}
+    long long getNumTrades() const {return numTrades;}
+    long long getNumSnapshots() const {return numSnapshots;}
+    bool isOpen() const {return running.load();}
+    /**** main ****/
+    bool open();
+    void writeTrade(const Trade& trade);
+    void writeTrades(const vector<Trade>& trades, int begin=0);
+    void writeDepths(int time, const PriceLevels& bids, const PriceLevels& asks);
+    bool close();
+};
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef TIMESERIES_HPP
+#define TIMESERIES_HPP
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+using namespace std;
+
+/**** class declarations ******************************************************/
+
+template <typename T>
+class TimeSeries {
+    // values keyed by time in two contiguous columns sorted by time, with
+    // the map interface the stats used before; appending a later time is
+    // O(1), other times are found by binary search
+private:
+    vector<int> times;
+    vector<T> values;
+    size_t find(int time) const {return lower_bound(times.begin(), times.end(), time)-times.begin();}
+public:
+    /**** constructors ****/
+    TimeSeries(size_t capacity=0) {reserve(capacity);}
+    /**** accessors ****/
+    size_t size() const {return times.size();}
+    bool empty() const {return times.empty();}
+    const vector<int>& getTimes() const {return times;}
+    const vector<T>& getValues() const {return values;}
+    int getTime(size_t i) const {return times[i];}
+    const T& getValue(size_t i) const {return values[i];}
+    size_t count(int time) const {
+        size_t i = find(time);
+        return i<times.size() && times[i]==time;
+    }
+    const T& at(int time) const {
+        size_t i = find(time);
+        if (i==times.size() || times[i]!=time) throw out_of_range("TimeSeries::at");
+        return values[i];
+    }
+    T& at(int time) {return const_cast<T&>(static_cast<const TimeSeries&>(*this).at(time));}
+    bool operator==(const TimeSeries& series) const {return times==series.times && values==series.values;}
+    bool operator!=(const TimeSeries& series) const {return !(*this==series);}
+    /**** mutators ****/
+    void reserve(size_t capacity) {
+        times.reserve(capacity);
+        values.reserve(capacity);
+    }
+    void clear() {
+        times.clear();
+        values.clear();
+    }
+    T& operator[](int time) {
+        if (times.empty() || time > times.back()) {
+            times.push_back(time);
+            values.push_back(T());
+            return values.back();
+        }
+        size_t i = find(time);
+        if (times[i] != time) {
+            times.insert(times.begin()+i, time);
+            values.insert(values.begin()+i, T());
+        }
+        return values[i];
+    }
+};
+
+template <class S, typename T>
+S& operator<<(S& out, const TimeSeries<T>& series) {
+    // print as a map of time to value
+    out << "{";
+    for (size_t i=0; i<series.size(); i++)
+        out << ((i)?",":"") << "\"" << series.getTime(i) << "\"" << ":" << series.getValue(i);
+    out << "}";
+    return out;
+}
+
+#endif
@@ -7,13 +7,32 @@
 #include <vector>
 #include <deque>
 #include <map>
+#include <atomic>
+#include "randomEngine.hpp"
 using namespace std;
 
 inline void seperator(int length=20){cout << string(length,'-') << endl;}
-inline double uniformRand(double min=0, double max=1){return min+(max-min)*rand()/RAND_MAX;}
-inline int uniformIntRand(double min, double max){return floor(uniformRand(min,max+1));}
-inline double exponentialRand(double lambda){return -log(uniformRand())/lambda;} // lambda: intensity
-inline double normalRand(double mu=0, double sig=1){return mu+sig*sqrt(-2*log(uniformRand()))*cos(2*M_PI*uniformRand());}
+struct GlobalRandState {atomic<unsigned long long> seed; atomic<int> generation; atomic<int> numStreams;};
+inline GlobalRandState& globalRandState(){static GlobalRandState state; return state;} // zero-initialized
+inline RandomEngine& defaultRandomEngine(){
+    // the k-th thread to draw gets the global seed jumped k times, so threads
+    // never share a stream; all of them reseed after a seedRand
+    static thread_local int stream = globalRandState().numStreams++;
+    static thread_local int generation = -1;
+    static thread_local RandomEngine rng;
+    int gen = globalRandState().generation.load(memory_order_acquire);
+    if (generation != gen) {
+        rng.setSeed(globalRandState().seed.load(memory_order_relaxed));
+        for (int i=0; i<stream; i++) rng.jump();
+        generation = gen;
+    }
+    return rng;
+}
+inline void seedRand(unsigned long long seed){globalRandState().seed.store(seed, memory_order_relaxed); globalRandState().generation.fetch_add(1, memory_order_release);}
+inline double uniformRand(double min=0, double max=1){return defaultRandomEngine().uniform(min,max);}
+inline int uniformIntRand(double min, double max){return defaultRandomEngine().uniformInt(min,max);}
+inline double exponentialRand(double lambda){return defaultRandomEngine().exponential(lambda);} // lambda: intensity
+inline double normalRand(double mu=0, double sig=1){return defaultRandomEngine().normal(mu,sig);}
 inline double normalPDF(double x, double mu=0, double sig=1){return exp(-(x-mu)*(x-mu)/(2*sig*sig))/(sqrt(2*M_PI)*sig);}
 inline double normalCDF(double x, double mu=0, double sig=1){return erfc(-M_SQRT1_2*x)/2;}
 inline double stdNormalPDF(double x){return normalPDF(x);}
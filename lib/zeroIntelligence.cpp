@@ -2,6 +2,7 @@
 #define ZEROINTELLIGENCE_CPP
 #include <fstream>
 #include <numeric>
+#include <algorithm>
 #include <vector>
 #include <deque>
 #include <map>
@@ -9,17 +10,56 @@
 #include "side.hpp"
 #include "orderType.hpp"
 #include "orderBook.hpp"
+#include "jsonWriter.hpp"
+#include "csvWriter.hpp"
+#include "checkpoint.hpp"
+#include "binaryLog.hpp"
+#include "depthJournal.hpp"
+#include "orderBookStats.hpp"
 #include "zeroIntelligence.hpp"
 using namespace std;
 
+/**** helper functions ********************************************************/
+
+static void writeDepthsLog(ostream& out, const map<int,map<double,int>>& depthsLog) {
+    writeBinary(out, (long long)depthsLog.size());
+    for (auto& snap : depthsLog) {
+        writeBinary(out, snap.first);
+        writeBinaryItems(out, snap.second);
+    }
+}
+
+static bool readDepthsLog(istream& in, map<int,map<double,int>>& depthsLog) {
+    long long n;
+    int t;
+    vector<pair<double,int>> depths;
+    depthsLog.clear();
+    if (!readBinary(in, n) || n < 0) return false;
+    for (long long i=0; i<n; i++) {
+        if (!readBinary(in, t) || !readBinaryItems(in, depths)) return false;
+        depthsLog[t].insert(depths.begin(), depths.end());
+    }
+    return true;
+}
+
 /**** class functions *********************************************************/
 //### ZeroIntelligence class ###################################################
 
-ZeroIntelligence::ZeroIntelligence(): id(0), time(0), numOrder(0), numOrderSent(0), priceBnd(0), limPriceBnd(0), snapInterval(1e3), snapBookLevels(50), mktOrderArvRate(0), limOrderArvRate(0), cclOrderArvRate(0) {}
+ZeroIntelligence::ZeroIntelligence(): id(0), time(0), owner(0), numOrder(0), numOrderSent(0), priceBnd(0), limPriceBnd(0), snapInterval(1e3), snapBookLevels(50), mktOrderArvRate(0), limOrderArvRate(0), cclOrderArvRate(0), continuousTime(false), timeScale(1000), simTime(0), numUniformsUsed(0), writer(0), deltaSnaps(false), onlineStats(0) {
+    initRates();
+}
 
-ZeroIntelligence::ZeroIntelligence(int numOrder, int priceBnd, int limPriceBnd, double limOrderArvRate, double mktOrderArvRate, double cclOrderArvRate, int snapInterval, int snapBookLevels): id(0), time(0), numOrder(numOrder), numOrderSent(0), priceBnd(priceBnd), limPriceBnd(limPriceBnd), snapInterval(snapInterval), snapBookLevels(snapBookLevels), limOrderArvRate(limOrderArvRate), mktOrderArvRate(mktOrderArvRate), cclOrderArvRate(cclOrderArvRate) {}
+ZeroIntelligence::ZeroIntelligence(int numOrder, int priceBnd, int limPriceBnd, double limOrderArvRate, double mktOrderArvRate, double cclOrderArvRate, int snapInterval, int snapBookLevels): id(0), time(0), owner(0), numOrder(numOrder), numOrderSent(0), priceBnd(priceBnd), limPriceBnd(limPriceBnd), snapInterval(snapInterval), snapBookLevels(snapBookLevels), limOrderArvRate(limOrderArvRate), mktOrderArvRate(mktOrderArvRate), cclOrderArvRate(cclOrderArvRate), continuousTime(false), timeScale(1000), simTime(0), numUniformsUsed(0), writer(0), deltaSnaps(false), onlineStats(0) {
+    initRates();
+}
 
-ZeroIntelligence::ZeroIntelligence(const ZeroIntelligence& zi): id(zi.id), time(zi.time), numOrder(zi.numOrder), numOrderSent(zi.numOrderSent), priceBnd(zi.priceBnd), limPriceBnd(zi.limPriceBnd), snapInterval(zi.snapInterval), snapBookLevels(zi.snapBookLevels), limOrderArvRate(zi.limOrderArvRate), mktOrderArvRate(zi.mktOrderArvRate), cclOrderArvRate(zi.cclOrderArvRate), ob(zi.ob) {}
+ZeroIntelligence::ZeroIntelligence(const ZeroIntelligence& zi): id(zi.id), time(zi.time), owner(zi.owner), numOrder(zi.numOrder), numOrderSent(zi.numOrderSent), priceBnd(zi.priceBnd), limPriceBnd(zi.limPriceBnd), snapInterval(zi.snapInterval), snapBookLevels(zi.snapBookLevels), limOrderArvRate(zi.limOrderArvRate), mktOrderArvRate(zi.mktOrderArvRate), cclOrderArvRate(zi.cclOrderArvRate), continuousTime(zi.continuousTime), timeScale(zi.timeScale), simTime(zi.simTime), rng(zi.rng), uniforms(zi.uniforms), numUniformsUsed(zi.numUniformsUsed), ob(zi.ob), writer(0), deltaSnaps(zi.deltaSnaps), depthJournal(zi.depthJournal.getKeyInterval()), onlineStats(0) {
+    initRates();
+}
+
+ZeroIntelligence::~ZeroIntelligence() {
+    closeStream();
+}
 
 ZeroIntelligence* ZeroIntelligence::copy() const {
     return new ZeroIntelligence(*this);
@@ -37,6 +77,7 @@ int ZeroIntelligence::setPriceBnd(int priceBnd) {
 
 int ZeroIntelligence::setLimPriceBnd(int limPriceBnd) {
     this->limPriceBnd = limPriceBnd;
+    initRates();
     return this->limPriceBnd;
 }
 
@@ -52,106 +93,174 @@ int ZeroIntelligence::setSnapBookLevels(int snapBookLevels) {
 
 double ZeroIntelligence::setMktOrderArvRate(double arvRate) {
     this->mktOrderArvRate = arvRate;
+    initRates();
     return this->mktOrderArvRate;
 }
 
 double ZeroIntelligence::setLimOrderArvRate(double arvRate) {
     this->limOrderArvRate = arvRate;
+    initRates();
     return this->limOrderArvRate;
 }
 
 double ZeroIntelligence::setCclOrderArvRate(double arvRate) {
     this->cclOrderArvRate = arvRate;
+    initRates();
     return this->cclOrderArvRate;
 }
 
+bool ZeroIntelligence::setContinuousTime(bool continuousTime, double timeScale) {
+    // orders, trades and snaps are then stamped with simTime*timeScale
+    this->continuousTime = continuousTime;
+    this->timeScale = timeScale;
+    return this->continuousTime;
+}
+
+unsigned long long ZeroIntelligence::setSeed(unsigned long long seed) {
+    numUniformsUsed = uniforms.size();
+    return rng.setSeed(seed);
+}
+
+void ZeroIntelligence::setRandomEngine(const RandomEngine& rng) {
+    numUniformsUsed = uniforms.size();
+    this->rng = rng;
+}
+
+bool ZeroIntelligence::setDeltaSnaps(bool deltaSnaps, int keyInterval) {
+    // call before initOrderBook, the first snap is then a keyframe
+    this->deltaSnaps = deltaSnaps;
+    ob.setJournaling(deltaSnaps);
+    depthJournal.setKeyInterval(keyInterval);
+    return this->deltaSnaps;
+}
+
+void ZeroIntelligence::setOnlineStats(OrderBookStats* stats) {
+    // stats are then computed at every snap and full depth snapshots are
+    // no longer kept, unless streamed or journaled
+    onlineStats = stats;
+    if (stats) stats->reserveStats(numOrder/max(1,snapInterval)+1);
+}
+
 void ZeroIntelligence::initOrderBook(vector<int> sizes) {
-    setTradesClock(0);
+    ob.setClock(0);
+    owner = ob.registerOwner("ZI");
     if (!sizes.size()) sizes = {1,2,2,3,3,4,4,5};
     int limit = 1, idx = 0;
     while (limit <= priceBnd) {
         for (int i=0; i<sizes[idx]; i++) {
-            ob.process(LimitOrder(id++,0,"ZI",BID,1,-limit));
-            ob.process(LimitOrder(id++,0,"ZI",ASK,1,+limit));
+            ob.processOrder(OrderMsg(LIMIT,id++,0,owner,BID,1,-limit));
+            ob.processOrder(OrderMsg(LIMIT,id++,0,owner,ASK,1,+limit));
         }
         idx = min(idx+1,(int)sizes.size()-1);
         limit++;
     }
+    syncDepthBtw();
     snapBook();
 }
 
 void ZeroIntelligence::sendLimitOrder(Side side) {
     int limit;
     int L = limPriceBnd;
-    if (side == BID) {
-        int a = ob.getTopAsk();
-        limit = uniformIntRand(a-L,a-1);
-    } else {
-        int b = ob.getTopBid();
-        limit = uniformIntRand(b+1,b+L);
-    }
-    ob.process(LimitOrder(id++,time++,"ZI",side,1,limit));
+    int a = ob.getTopAsk();
+    int b = ob.getTopBid();
+    if (side == BID) limit = drawUniformInt(a-L,a-1);
+    else limit = drawUniformInt(b+1,b+L);
+    int depth = (side==BID)?ob.getBidDepthAt(limit):ob.getAskDepthAt(limit);
+    ob.processOrder(OrderMsg(LIMIT,id++,time,owner,side,1,limit));
+    trackDepthBtw(a, b, side, limit, depth);
 }
 
 void ZeroIntelligence::sendMarketOrder(Side side) {
-    ob.process(MarketOrder(id++,time++,"ZI",side,1));
+    // fills at the top of the other side, if any
+    int a = ob.getTopAsk();
+    int b = ob.getTopBid();
+    double price = (side==BID)?a:b;
+    int depth = (side==BID)?ob.getAskDepthAt(price):ob.getBidDepthAt(price);
+    ob.processOrder(OrderMsg(MARKET,id++,time,owner,side,1));
+    trackDepthBtw(a, b, (side==BID)?ASK:BID, price, depth);
 }
 
 void ZeroIntelligence::sendCancelOrder(Side side, int depthBtw) {
     int idRef = -1;
-    int cumDepth = 0;
     int L = limPriceBnd;
-    double limit;
+    int a = ob.getTopAsk();
+    int b = ob.getTopBid();
+    double price = 0;
     if (side == BID) {
-        int a = ob.getTopAsk();
-        int threshold = uniformIntRand(1,(depthBtw)?depthBtw:ob.getBidDepthBetween(a-L,a-1));
-        deque<double>* bidPrices = ob.getBidPricesPtr();
-        map<double,int>* bidDepths = ob.getBidDepthsPtr();
-        for (auto p : *bidPrices) {
-            cumDepth += bidDepths->at(p);
-            if (cumDepth >= threshold) {
-                limit = p; break;
-            }
-        }
-        idRef = ob.peekBidOrderAt(limit)->getId();
+        int threshold = drawUniformInt(1,(depthBtw)?depthBtw:ob.getBidDepthBetween(a-L,a-1));
+        idRef = ob.getBidIdAtDepth(threshold);
+        price = ob.getBidPriceAtDepth(threshold);
     } else if (side == ASK) {
-        int b = ob.getTopBid();
-        int threshold = uniformIntRand(1,(depthBtw)?depthBtw:ob.getAskDepthBetween(b+1,b+L));
-        deque<double>* askPrices = ob.getAskPricesPtr();
-        map<double,int>* askDepths = ob.getAskDepthsPtr();
-        for (auto p : *askPrices) {
-            cumDepth += askDepths->at(p);
-            if (cumDepth >= threshold) {
-                limit = p; break;
-            }
-        }
-        idRef = ob.peekAskOrderAt(limit)->getId();
+        int threshold = drawUniformInt(1,(depthBtw)?depthBtw:ob.getAskDepthBetween(b+1,b+L));
+        idRef = ob.getAskIdAtDepth(threshold);
+        price = ob.getAskPriceAtDepth(threshold);
     }
-    ob.process(CancelOrder(id++,time++,"ZI",idRef));
+    int depth = (side==BID)?ob.getBidDepthAt(price):ob.getAskDepthAt(price);
+    ob.processOrder(OrderMsg(CANCEL,id++,time,owner,idRef));
+    trackDepthBtw(a, b, side, price, depth);
 }
 
-void ZeroIntelligence::generateOrder() {
-    int event = 0;
+void ZeroIntelligence::initRates() {
+    rates[0] = rates[1] = limPriceBnd*limOrderArvRate;
+    rates[2] = rates[3] = mktOrderArvRate/2;
+    baseRate = rates[0]+rates[1]+rates[2]+rates[3];
+    syncDepthBtw();
+}
+
+void ZeroIntelligence::syncDepthBtw() {
+    // window depths from scratch, tracked per event from then on
     int a = ob.getTopAsk();
     int b = ob.getTopBid();
     int L = limPriceBnd;
-    int bidDepthBtw = ob.getBidDepthBetween(a-L,a-1);
-    int askDepthBtw = ob.getAskDepthBetween(b+1,b+L);
-    double p = uniformRand();
-    vector<double> prob{
-        limPriceBnd*limOrderArvRate,
-        limPriceBnd*limOrderArvRate,
-        mktOrderArvRate/2,
-        mktOrderArvRate/2,
-        bidDepthBtw*cclOrderArvRate,
-        askDepthBtw*cclOrderArvRate,
-    };
-    double totalProb = accumulate(prob.begin(), prob.end(), 0);
-    transform(prob.begin(), prob.end(), prob.begin(), [totalProb](double& p){return p/totalProb;});
-    while (p > prob[event]) {
-        p -= prob[event];
+    bidDepthBtw = ob.getBidDepthBetween(a-L,a-1);
+    askDepthBtw = ob.getAskDepthBetween(b+1,b+L);
+    updateRates();
+}
+
+int ZeroIntelligence::shiftDepthBtw(Side side, int lo0, int lo1, int depthBtw) {
+    // depth of the window of limPriceBnd ticks moved from lo0 to lo1, only
+    // the ticks entering and leaving it are queried
+    int L = limPriceBnd;
+    LimitOrderBook* b = &ob;
+    auto depthBetween = [b,side](int p0, int p1) {return (side==BID)?b->getBidDepthBetween(p0,p1):b->getAskDepthBetween(p0,p1);};
+    if (lo1 == lo0) return depthBtw;
+    if (abs(lo1-lo0) >= L) return depthBetween(lo1,lo1+L-1);
+    if (lo1 > lo0) return depthBtw+depthBetween(lo0+L,lo1+L-1)-depthBetween(lo0,lo1-1);
+    return depthBtw+depthBetween(lo1,lo0-1)-depthBetween(lo1+L,lo0+L-1);
+}
+
+void ZeroIntelligence::trackDepthBtw(int a0, int b0, Side side, double price, int depth0) {
+    // an event changes one level, at price on side, and may move the tops
+    // from a0 and b0; the window depths follow both
+    int L = limPriceBnd;
+    int depth = (side==BID)?ob.getBidDepthAt(price):ob.getAskDepthAt(price);
+    if (side == BID && price >= a0-L && price <= a0-1) bidDepthBtw += depth-depth0;
+    if (side == ASK && price >= b0+1 && price <= b0+L) askDepthBtw += depth-depth0;
+    bidDepthBtw = shiftDepthBtw(BID, a0-L, (int)ob.getTopAsk()-L, bidDepthBtw);
+    askDepthBtw = shiftDepthBtw(ASK, b0+1, (int)ob.getTopBid()+1, askDepthBtw);
+}
+
+void ZeroIntelligence::updateRates() {
+    // only the cancel rates depend on the book, through the window depths
+    rates[4] = bidDepthBtw*cclOrderArvRate;
+    rates[5] = askDepthBtw*cclOrderArvRate;
+    totalRate = baseRate+rates[4]+rates[5];
+}
+
+void ZeroIntelligence::generateOrder() {
+    // in continuous time the clock jumps to the event, else it counts events
+    int event = 0;
+    updateRates();
+    double u = drawUniform()*totalRate;
+    while (event < 5 && u >= rates[event]) {
+        u -= rates[event];
         event++;
     }
+    if (continuousTime) {
+        simTime += -log(1-drawUniform())/totalRate;
+        time = max(time, (int)(simTime*timeScale));
+        ob.setClock(time);
+    }
     switch(event) {
         case 0: sendLimitOrder(BID); break;
         case 1: sendLimitOrder(ASK); break;
@@ -161,70 +270,190 @@ void ZeroIntelligence::generateOrder() {
         case 5: sendCancelOrder(ASK,askDepthBtw); break;
         default: return;
     }
+    if (!continuousTime) time++;
 }
 
 void ZeroIntelligence::simulate() {
+    // a snap is taken whenever the clock passes a multiple of snapInterval
     while (numOrderSent < numOrder) {
+        int prevTime = time;
         generateOrder();
-        setTradesClock(time);
+        ob.setClock(time);
         numOrderSent++;
-        snapBook();
+        if (writer) {
+            // hand the new trades over and keep the book's log empty
+            writer->writeTrades(*ob.getTradesPtr());
+            ob.getTradesPtr()->clear();
+        }
+        if (time/snapInterval != prevTime/snapInterval) snapBook();
     }
 }
 
 void ZeroIntelligence::snapBook() {
-    if (time % snapInterval == 0) {
+    // the book at the current time
+    if (onlineStats) onlineStats->updateStats(time, ob);
+    if (writer) writer->writeDepths(time, *ob.getBidLevelsPtr(), *ob.getAskLevelsPtr());
+    else if (deltaSnaps) depthJournal.record(time, *ob.getBidLevelsPtr(), *ob.getAskLevelsPtr());
+    else if (!onlineStats) {
         bidDepthsLog[time] = ob.snapBidDepths(snapBookLevels);
         askDepthsLog[time] = ob.snapAskDepths(snapBookLevels);
     }
 }
 
+void ZeroIntelligence::rebuildDepthsLog() {
+    // full snapshots from the delta journal, for the depth log printers
+    depthJournal.getDepthsLog(bidDepthsLog, askDepthsLog, snapBookLevels);
+}
+
 void ZeroIntelligence::printBook(int bookLevels, int tradeLevels, bool summarizeDepth) const {
     ob.printBook(bookLevels, tradeLevels, summarizeDepth);
 }
 
 void ZeroIntelligence::printTradesToJson(string filename) {
+    // one buffer handed to the file whenever it fills up
+    const vector<Trade>& trades = *ob.getTradesPtr();
+    JsonWriter out(1<<16);
     ofstream f; f.open(filename);
-    f << *ob.getTradesPtr() << endl;
+    out << "[";
+    for (size_t i=0; i<trades.size(); i++) {
+        out << ((i)?",":"") << trades[i];
+        if (out.size() >= (1<<16)) out.writeTo(f);
+    }
+    out << "]\n";
+    out.writeTo(f);
     f.close();
 }
 
 void ZeroIntelligence::printDepthsLogToJson(string filename) {
+    JsonWriter out(1<<16);
     ofstream f; f.open(filename);
-    f << "{\"BID\":" << bidDepthsLog << ",\"ASK\":" << askDepthsLog << "}" << endl;
+    out << "{\"BID\":" << bidDepthsLog << ",\"ASK\":" << askDepthsLog << "}\n";
+    out.writeTo(f);
     f.close();
 }
 
-void ZeroIntelligence::printTradesToCsv(string filename) {
-    deque<Trade*> trades = *ob.getTradesPtr();
-    ofstream f; f.open(filename);
-    f << "TIME,ID,SIZE,PRICE,DIRECTION" << endl;
-    for (auto t : trades) {
-        int time      = t->getTime();
-        int id        = t->getId(); // bookOrder (LIM)
-        int size      = t->getSize();
-        int price     = t->getPrice();
-        int direction = (t->getSide()==BID)?1:-1; // matchOrder (MKT)
-        f << time << "," << id << "," << size << "," << price << "," << direction << endl;
-    }
-    f.close();
+void ZeroIntelligence::printTradesToCsv(string filename, int numThreads) {
+    CsvWriter(numThreads).writeTrades(filename, *ob.getTradesPtr());
 }
 
-void ZeroIntelligence::printDepthsLogToCsv(string filename) {
-    ofstream f; f.open(filename);
-    f << "TIME";
-    for (int i=1; i<=snapBookLevels; i++) f << ",BID" << i << "_PRICE" << ",BID" << i << "_SIZE";
-    for (int i=1; i<=snapBookLevels; i++) f << ",ASK" << i << "_PRICE" << ",ASK" << i << "_SIZE";
-    f << endl;
-    for (int t=0; t<=time; t+=snapInterval) {
-        map<double,int> b = bidDepthsLog.at(t);
-        map<double,int> a = askDepthsLog.at(t);
-        f << t;
-        for (auto i=b.rbegin(); i!=b.rend(); i++) f << "," << i->first << "," << i->second;
-        for (auto i=a.begin(); i!=a.end(); i++) f << "," << i->first << "," << i->second;
-        f << endl;
-    }
+void ZeroIntelligence::printDepthsLogToCsv(string filename, int numThreads) {
+    CsvWriter(numThreads).writeDepthsLog(filename, bidDepthsLog, askDepthsLog, snapBookLevels);
+}
+
+void ZeroIntelligence::printTradesToBin(string filename) {
+    TradeLogFile::write(filename, *ob.getTradesPtr());
+}
+
+void ZeroIntelligence::printDepthsLogToBin(string filename) {
+    DepthLogFile::write(filename, bidDepthsLog, askDepthsLog, snapBookLevels, snapInterval);
+}
+
+bool ZeroIntelligence::streamToCsv(string tradesFile, string depthsFile, int queueSize) {
+    // call before initOrderBook, trades and snapshots then go to the files
+    // as they are produced and are no longer kept in memory; false if the
+    // files cannot be opened, outputs are then logged as without a stream
+    closeStream();
+    writer = new StreamWriter(tradesFile, depthsFile, snapBookLevels, queueSize);
+    if (writer->isOpen()) return true;
+    delete writer;
+    writer = 0;
+    return false;
+}
+
+bool ZeroIntelligence::closeStream() {
+    // false if there was no stream or a write failed
+    if (!writer) return false;
+    bool written = writer->close();
+    delete writer;
+    writer = 0;
+    return written;
+}
+
+bool ZeroIntelligence::saveCheckpoint(string filename, bool history) const {
+    // the simulation state, the random stream mid-block included, then the
+    // book; without history, trades and depth logs are left
+    // out; stream writers, online stats and the delta journal are not saved
+    ofstream f(filename, ios::binary);
+    writeCheckpointHeader(f, "OBSZISIM", CHECKPOINT_VERSION, (history)?CHECKPOINT_HISTORY:0);
+    for (int x : {id, time, owner, numOrder, numOrderSent, priceBnd, limPriceBnd, snapInterval, snapBookLevels, bidDepthBtw, askDepthBtw})
+        writeBinary(f, x);
+    for (double x : {limOrderArvRate, mktOrderArvRate, cclOrderArvRate, timeScale, simTime, baseRate, totalRate})
+        writeBinary(f, x);
+    writeBinary(f, rates);
+    writeBinary(f, continuousTime);
+    writeBinary(f, deltaSnaps);
+    writeBinary(f, depthJournal.getKeyInterval());
+    writeBinary(f, rng.getSeed());
+    for (int i=0; i<4; i++) writeBinary(f, rng.getState()[i]);
+    writeBinary(f, rng.getHasSpareNormal());
+    writeBinary(f, rng.getSpareNormal());
+    writeBinaryItems(f, uniforms);
+    writeBinary(f, numUniformsUsed);
+    writeDepthsLog(f, (history)?bidDepthsLog:map<int,map<double,int>>());
+    writeDepthsLog(f, (history)?askDepthsLog:map<int,map<double,int>>());
+    ob.writeCheckpoint(f, history);
     f.close();
+    return !f.fail();
+}
+
+bool ZeroIntelligence::loadCheckpoint(string filename) {
+    // simulate() then carries on exactly where the saved run stopped; the
+    // simulation is only replaced once the whole checkpoint is read and
+    // checked, it is left unchanged otherwise
+    ifstream f(filename, ios::binary);
+    int flags, keyInterval;
+    int id, time, owner, numOrder, numOrderSent, priceBnd, limPriceBnd, snapInterval, snapBookLevels, bidDepthBtw, askDepthBtw;
+    double limOrderArvRate, mktOrderArvRate, cclOrderArvRate, timeScale, simTime, baseRate, totalRate;
+    double rates[6];
+    bool continuousTime, deltaSnaps;
+    unsigned long long seed, state[4];
+    bool hasSpareNormal;
+    double spareNormal;
+    vector<double> uniforms;
+    int numUniformsUsed;
+    map<int,map<double,int>> bidDepthsLog, askDepthsLog;
+    if (!f || !readCheckpointHeader(f, "OBSZISIM", CHECKPOINT_VERSION, flags)) return false;
+    for (int* x : {&id, &time, &owner, &numOrder, &numOrderSent, &priceBnd, &limPriceBnd, &snapInterval, &snapBookLevels, &bidDepthBtw, &askDepthBtw})
+        if (!readBinary(f, *x)) return false;
+    for (double* x : {&limOrderArvRate, &mktOrderArvRate, &cclOrderArvRate, &timeScale, &simTime, &baseRate, &totalRate})
+        if (!readBinary(f, *x)) return false;
+    if (!readBinary(f, rates) || !readBinary(f, continuousTime) || !readBinary(f, deltaSnaps) || !readBinary(f, keyInterval)) return false;
+    if (!readBinary(f, seed) || !readBinary(f, state) || !readBinary(f, hasSpareNormal) || !readBinary(f, spareNormal)) return false;
+    if (!readBinaryItems(f, uniforms) || !readBinary(f, numUniformsUsed)) return false;
+    if (!readDepthsLog(f, bidDepthsLog) || !readDepthsLog(f, askDepthsLog)) return false;
+    if (numUniformsUsed < 0 || numUniformsUsed > (int)uniforms.size()) return false;
+    if (id < 0 || numOrder < 0 || numOrderSent < 0 || priceBnd < 0 || limPriceBnd <= 0) return false;
+    if (snapInterval <= 0 || snapBookLevels < 0 || bidDepthBtw < 0 || askDepthBtw < 0 || !(timeScale > 0)) return false;
+    if (!ob.readCheckpoint(f)) return false;
+    this->id = id;
+    this->time = time;
+    this->owner = owner;
+    this->numOrder = numOrder;
+    this->numOrderSent = numOrderSent;
+    this->priceBnd = priceBnd;
+    this->limPriceBnd = limPriceBnd;
+    this->snapInterval = snapInterval;
+    this->snapBookLevels = snapBookLevels;
+    this->bidDepthBtw = bidDepthBtw;
+    this->askDepthBtw = askDepthBtw;
+    this->limOrderArvRate = limOrderArvRate;
+    this->mktOrderArvRate = mktOrderArvRate;
+    this->cclOrderArvRate = cclOrderArvRate;
+    this->timeScale = timeScale;
+    this->simTime = simTime;
+    this->baseRate = baseRate;
+    this->totalRate = totalRate;
+    std::copy(rates, rates+6, this->rates);
+    this->continuousTime = continuousTime;
+    this->deltaSnaps = deltaSnaps;
+    rng.setState(seed, state, hasSpareNormal, spareNormal);
+    this->uniforms.swap(uniforms);
+    this->numUniformsUsed = numUniformsUsed;
+    this->bidDepthsLog.swap(bidDepthsLog);
+    this->askDepthsLog.swap(askDepthsLog);
+    depthJournal.setKeyInterval(keyInterval);
+    ob.setJournaling(deltaSnaps);
+    return true;
 }
 
 #endif
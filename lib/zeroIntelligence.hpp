@@ -3,9 +3,15 @@
 #include <vector>
 #include <deque>
 #include <map>
+#include <cmath>
 #include "side.hpp"
 #include "orderType.hpp"
 #include "orderBook.hpp"
+#include "randomEngine.hpp"
+#include "streamWriter.hpp"
+#include "binaryLog.hpp"
+#include "depthJournal.hpp"
+#include "orderBookStats.hpp"
 using namespace std;
 
 /**** class declarations ******************************************************/
@@ -14,17 +20,47 @@ class ZeroIntelligence {
 private:
     int id;
     int time;
+    int owner; // owner id of "ZI" in the book
     int numOrder, numOrderSent;
     int priceBnd, limPriceBnd;
     int snapInterval, snapBookLevels;
     double mktOrderArvRate;
     double limOrderArvRate;
     double cclOrderArvRate;
+    bool continuousTime; // draw exponential inter-arrival times
+    double timeScale; // clock ticks per unit of simTime in continuous time
+    double simTime;
+    double rates[6]; // limit bid/ask, market bid/ask, cancel bid/ask
+    double baseRate; // total rate of limit and market orders
+    double totalRate;
+    int bidDepthBtw, askDepthBtw; // depth within limPriceBnd of the far top
+    RandomEngine rng;
+    vector<double> uniforms; // block of pre-drawn uniforms on [0,1)
+    int numUniformsUsed;
     LimitOrderBook ob;
     map<int,map<double,int>> bidDepthsLog, askDepthsLog;
+    StreamWriter* writer; // streams trades and snapshots instead of logging
+    bool deltaSnaps; // journal changed levels instead of full snapshots
+    DepthJournal depthJournal;
+    OrderBookStats* onlineStats; // updated at each snap, not owned
+    static const int RANDOM_BLOCK = 1024;
+    static const int CHECKPOINT_VERSION = 2;
+    double drawUniform() {
+        if (numUniformsUsed == (int)uniforms.size()) {
+            uniforms.resize(RANDOM_BLOCK);
+            rng.fillUniform(uniforms.data(), RANDOM_BLOCK);
+            numUniformsUsed = 0;
+        }
+        return uniforms[numUniformsUsed++];
+    }
+    int drawUniformInt(int min, int max) {return floor(min+(max-min+1)*drawUniform());}
+    void initRates();
+    void syncDepthBtw();
+    int shiftDepthBtw(Side side, int lo0, int lo1, int depthBtw);
+    void trackDepthBtw(int a0, int b0, Side side, double price, int depth0);
 public:
     /**** constructors ****/
-    ZeroIntelligence(); virtual ~ZeroIntelligence(){};
+    ZeroIntelligence(); virtual ~ZeroIntelligence();
     ZeroIntelligence(int numOrder, int priceBnd, int limPriceBnd,
         double limOrderArvRate, double mktOrderArvRate, double cclOrderArvRate,
         int snapInterval=1e3, int snapBookLevels=50);
@@ -42,21 +78,29 @@ public:
     double getMktOrderArvRate() const {return mktOrderArvRate;}
     double getLimOrderArvRate() const {return limOrderArvRate;}
     double getCclOrderArvRate() const {return cclOrderArvRate;}
-    deque<Trade*> getTrades() const {return ob.getTrades();}
-    deque<Trade*>* getTradesPtr() {return ob.getTradesPtr();}
+    bool getContinuousTime() const {return continuousTime;}
+    double getTimeScale() const {return timeScale;}
+    double getSimTime() const {return simTime;}
+    double getTotalRate() const {return totalRate;}
+    unsigned long long getSeed() const {return rng.getSeed();}
+    RandomEngine* getRandomEnginePtr() {return &rng;}
+    vector<Trade> getTrades() const {return ob.getTrades();}
+    vector<Trade>* getTradesPtr() {return ob.getTradesPtr();}
     map<int,Order*> getOrdersLog() const {return ob.getOrdersLog();}
-    map<int,Order*>* getOrdersLogPtr() {return ob.getOrdersLogPtr();}
+    OrderLog<OrderMsg>* getOrdersLogPtr() {return ob.getOrdersLogPtr();}
     map<double,int> getBidDepths() const {return ob.getBidDepths();}
     map<double,int> getAskDepths() const {return ob.getAskDepths();}
-    map<double,int>* getBidDepthsPtr() {return ob.getBidDepthsPtr();}
-    map<double,int>* getAskDepthsPtr() {return ob.getAskDepthsPtr();}
-    map<double,deque<LimitOrder*>>* getBidsPtr() {return ob.getBidsPtr();}
-    map<double,deque<LimitOrder*>>* getAsksPtr() {return ob.getAsksPtr();}
+    PriceLevels* getBidLevelsPtr() {return ob.getBidLevelsPtr();}
+    PriceLevels* getAskLevelsPtr() {return ob.getAskLevelsPtr();}
     map<int,map<double,int>> getBidDepthsLog() const {return bidDepthsLog;}
     map<int,map<double,int>> getAskDepthsLog() const {return askDepthsLog;}
     map<int,map<double,int>>* getBidDepthsLogPtr() {return &bidDepthsLog;}
     map<int,map<double,int>>* getAskDepthsLogPtr() {return &askDepthsLog;}
     LimitOrderBook* getLimitOrderBookPtr() {return &ob;}
+    StreamWriter* getStreamWriterPtr() {return writer;}
+    bool getDeltaSnaps() const {return deltaSnaps;}
+    DepthJournal* getDepthJournalPtr() {return &depthJournal;}
+    OrderBookStats* getOnlineStatsPtr() {return onlineStats;}
     /**** mutators ****/
     int setNumOrder(int numOrder);
     int setPriceBnd(int priceBnd);
@@ -66,20 +110,33 @@ public:
     double setMktOrderArvRate(double arvRate);
     double setLimOrderArvRate(double arvRate);
     double setCclOrderArvRate(double arvRate);
+    bool setContinuousTime(bool continuousTime, double timeScale=1000);
+    unsigned long long setSeed(unsigned long long seed);
+    void setRandomEngine(const RandomEngine& rng);
+    bool setDeltaSnaps(bool deltaSnaps, int keyInterval=1000);
+    void setOnlineStats(OrderBookStats* stats);
     /**** main ****/
     virtual void initOrderBook(vector<int> sizes={});
     virtual void sendLimitOrder(Side side);
     virtual void sendMarketOrder(Side side);
     virtual void sendCancelOrder(Side side, int depthBtw=0);
+    virtual void updateRates();
     virtual void generateOrder();
     void simulate();
     void snapBook();
+    void rebuildDepthsLog();
     void printBook(int bookLevels=0, int tradeLevels=0,
         bool summarizeDepth=true) const;
     void printTradesToJson(string filename);
     void printDepthsLogToJson(string filename);
-    void printTradesToCsv(string filename);
-    void printDepthsLogToCsv(string filename);
+    void printTradesToCsv(string filename, int numThreads=1);
+    void printDepthsLogToCsv(string filename, int numThreads=1);
+    void printTradesToBin(string filename);
+    void printDepthsLogToBin(string filename);
+    bool streamToCsv(string tradesFile, string depthsFile, int queueSize=1<<16);
+    bool closeStream();
+    bool saveCheckpoint(string filename, bool history=true) const;
+    bool loadCheckpoint(string filename);
 };
 
 #endif
@@ -0,0 +1,62 @@
+#ifndef ZEROINTELLIGENCEENSEMBLE_CPP
+#define ZEROINTELLIGENCEENSEMBLE_CPP
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "randomEngine.hpp"
+#include "zeroIntelligence.hpp"
+#include "orderBookStats.hpp"
+#include "zeroIntelligenceEnsemble.hpp"
+using namespace std;
+
+/**** class functions *********************************************************/
+//### ZeroIntelligenceEnsemble class ###########################################
+
+ZeroIntelligenceEnsemble::ZeroIntelligenceEnsemble(const ZeroIntelligence& model, int numSim, unsigned long long seed, int numThreads): numSim(numSim), numThreads(numThreads), seed(seed), model(model) {
+    setNumThreads(numThreads);
+}
+
+int ZeroIntelligenceEnsemble::setNumSim(int numSim) {
+    this->numSim = numSim;
+    return this->numSim;
+}
+
+int ZeroIntelligenceEnsemble::setNumThreads(int numThreads) {
+    this->numThreads = (numThreads>0)?numThreads:max(1,(int)thread::hardware_concurrency());
+    return this->numThreads;
+}
+
+unsigned long long ZeroIntelligenceEnsemble::setSeed(unsigned long long seed) {
+    this->seed = seed;
+    return this->seed;
+}
+
+void ZeroIntelligenceEnsemble::simulate(vector<int> sizes) {
+    atomic<int> next(0);
+    mutex statsMutex;
+    stats.clearStats();
+    auto runSims = [&]() {
+        for (int k=next++; k<numSim; k=next++) {
+            ZeroIntelligence zi(model);
+            RandomEngine rng(seed);
+            for (int j=0; j<k; j++) rng.jump();
+            zi.setRandomEngine(rng);
+            zi.initOrderBook(sizes);
+            zi.simulate();
+            if (zi.getDeltaSnaps()) zi.rebuildDepthsLog();
+            lock_guard<mutex> lock(statsMutex);
+            stats.merge(*zi.getBidDepthsLogPtr(), *zi.getAskDepthsLogPtr(), *zi.getTradesPtr(), getTimeOffset(k));
+        }
+    };
+    vector<thread> pool;
+    for (int i=0; i<min(numThreads,numSim); i++) pool.push_back(thread(runSims));
+    for (auto& t : pool) t.join();
+    // runs are merged as they finish, time offsets restore the run order
+    vector<Trade>* trades = stats.getTradesPtr();
+    stable_sort(trades->begin(), trades->end(), [](const Trade& a, const Trade& b){return a.getTime()<b.getTime();});
+    stats.initStats();
+}
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef ZEROINTELLIGENCEENSEMBLE_HPP
+#define ZEROINTELLIGENCEENSEMBLE_HPP
+#include <vector>
+#include "zeroIntelligence.hpp"
+#include "orderBookStats.hpp"
+using namespace std;
+
+/**** class declarations ******************************************************/
+
+class ZeroIntelligenceEnsemble {
+    // runs numSim copies of a ZI model on a pool of threads, simulation k
+    // draws from the seed's stream jumped k times and is shifted in time by
+    // getTimeOffset(k), so the merged stats do not depend on the number of
+    // threads
+private:
+    int numSim, numThreads;
+    unsigned long long seed;
+    ZeroIntelligence model;
+    OrderBookStats stats;
+public:
+    /**** constructors ****/
+    ZeroIntelligenceEnsemble(const ZeroIntelligence& model, int numSim,
+        unsigned long long seed=0, int numThreads=0);
+    /**** accessors ****/
+    int getNumSim() const {return numSim;}
+    int getNumThreads() const {return numThreads;}
+    unsigned long long getSeed() const {return seed;}
+    int getTimeOffset(int k) const {return k*(model.getNumOrder()+1);}
+    ZeroIntelligence* getModelPtr() {return &model;}
+    OrderBookStats* getStatsPtr() {return &stats;}
+    /**** mutators ****/
+    int setNumSim(int numSim);
+    int setNumThreads(int numThreads);
+    unsigned long long setSeed(unsigned long long seed);
+    /**** main ****/
+    void simulate(vector<int> sizes={});
+};
+
+#endif
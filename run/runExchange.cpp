@@ -0,0 +1,72 @@
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include "util.cpp"
+#include "side.hpp"
+#include "orderType.hpp"
+#include "orderBook.hpp"
+#include "exchange.hpp"
+using namespace std;
+using namespace chrono;
+
+vector<OrderMsg> makeNaiveMsgs(int n) {
+    int id = 0;
+    vector<OrderMsg> msgs;
+    msgs.reserve(n);
+    for (int i=0; i<n; i++) {
+        Side side    = (uniformRand()<0.5)?BID:ASK;
+        int size     = (int)uniformRand(5,20);
+        int ccl      = (int)uniformRand(0,id);
+        double u     = uniformRand();
+        double price = (int)((side==BID)?uniformRand(70,105):uniformRand(95,130));
+        if (u<0.6) msgs.push_back(OrderMsg(LIMIT,id++,0,0,side,size,price));
+        else if (u<0.8) msgs.push_back(OrderMsg(MARKET,id++,0,0,side,size));
+        else msgs.push_back(OrderMsg(CANCEL,id++,0,0,ccl));
+    }
+    return msgs;
+}
+
+void runExchange(const vector<vector<OrderMsg>>& flows, int numShards) {
+    // one producer per shard, each producer owns the flows of its books so
+    // every book sees its orders in the original sequence
+    int numBooks = flows.size();
+    Exchange ex(numShards, numShards);
+    for (int b=0; b<numBooks; b++) ex.addBook("SYM"+to_string(b));
+    long long n = 0;
+    for (auto& flow : flows) n += flow.size();
+    ex.start();
+    auto t1 = high_resolution_clock::now();
+    vector<thread> producers;
+    for (int p=0; p<numShards; p++)
+        producers.push_back(thread([&,p]() {
+            vector<int> books;
+            for (int b=0; b<numBooks; b++) if (ex.getBookShard(b) == p) books.push_back(b);
+            for (int i=0; i<(int)flows[0].size(); i++)
+                for (int b : books) ex.submit(p, b, flows[b][i]);
+        }));
+    for (auto& t : producers) t.join();
+    ex.stop();
+    auto t2 = high_resolution_clock::now();
+    auto t = duration_cast<nanoseconds>(t2-t1);
+    bool same = true;
+    for (int b=0; b<numBooks; b++) {
+        LimitOrderBook ob;
+        ob.processBatch(flows[b]);
+        LimitOrderBook* exOb = ex.getBookPtr(b);
+        same = same && ob.getTradesPtr()->size() == exOb->getTradesPtr()->size()
+            && ob.getBidDepths() == exOb->getBidDepths() && ob.getAskDepths() == exOb->getAskDepths();
+    }
+    cout << "(shards = " << numShards << ") processing time per order: " << (float)t.count()/n << "ns, "
+         << n/(t.count()/1e9)/1e6 << "M orders/s, books match sequential: " << ((same)?"yes":"no") << endl;
+}
+
+int main() {
+    seedRand(0);
+    int numBooks = 16;
+    int n = 1<<16;
+    vector<vector<OrderMsg>> flows;
+    for (int b=0; b<numBooks; b++) flows.push_back(makeNaiveMsgs(n));
+    int numCores = max(1,(int)thread::hardware_concurrency());
+    for (int s=1; s<=numCores; s*=2) runExchange(flows, s);
+    return 0;
+}
@@ -0,0 +1,134 @@
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <algorithm>
+#include "util.cpp"
+#include "orderBook.hpp"
+#include "randomEngine.hpp"
+#include "itchReplay.hpp"
+using namespace std;
+using namespace chrono;
+
+void putU16(string& s, unsigned x) {s += (char)(x>>8); s += (char)x;}
+void putU32(string& s, unsigned x) {putU16(s, x>>16); putU16(s, x);}
+void putU64(string& s, unsigned long long x) {putU32(s, x>>32); putU32(s, x);}
+void putHeader(string& s, char type, int locate, unsigned long long timestamp) {
+    s += type; putU16(s, locate); putU16(s, 0); putU16(s, timestamp>>32); putU32(s, timestamp);
+}
+void putMsg(ofstream& f, const string& msg) {
+    string len; putU16(len, msg.size());
+    f << len << msg;
+}
+
+struct SampleOrder {
+    unsigned long long ref;
+    int size;
+    bool bid;
+};
+
+void writeSampleItch(string filename, int n, int numStocks) {
+    // ITCH 5.0 file with a random mix of adds, executions, cancels, deletes
+    // and replaces around $100 that never cross, for when no capture is at hand;
+    // each stock opens with stub quotes at $0.01 and $199,999.99
+    RandomEngine rng(0);
+    ofstream f(filename, ios::binary);
+    vector<vector<SampleOrder>> live(numStocks+1);
+    unsigned long long ref = 1, t = 34200000000000ULL; // 9:30
+    auto price = [&](bool bid, int minTicks) {return 1000000+((bid)?-1:1)*100*rng.uniformInt(minTicks, 50);};
+    for (int locate=1; locate<=numStocks; locate++) {
+        string msg; putHeader(msg, 'R', locate, t);
+        string stock = "STK"+to_string(locate); stock.resize(8, ' ');
+        msg += stock; msg.resize(39, ' ');
+        putMsg(f, msg);
+        for (int bid=0; bid<2; bid++) {
+            string stub; putHeader(stub, 'A', locate, t);
+            putU64(stub, ref++); stub += (bid)?'B':'S'; putU32(stub, 100);
+            stub += "STK     "; putU32(stub, (bid)?100:1999999900);
+            putMsg(f, stub);
+        }
+    }
+    for (int i=0; i<n; i++) {
+        int locate = rng.uniformInt(1, numStocks);
+        vector<SampleOrder>& orders = live[locate];
+        double u = rng.uniform();
+        string msg;
+        t += 1000;
+        if (u < 0.45 || orders.size() < 10) {
+            SampleOrder o = {ref++, 100*rng.uniformInt(1, 10), rng.uniform()<0.5};
+            putHeader(msg, (rng.uniform()<0.9)?'A':'F', locate, t);
+            putU64(msg, o.ref); msg += (o.bid)?'B':'S'; putU32(msg, o.size);
+            msg += "STK     "; putU32(msg, price(o.bid, 1));
+            if (msg[0] == 'F') msg += "MPID";
+            orders.push_back(o);
+        } else {
+            int k = rng.uniformInt(0, orders.size()-1);
+            SampleOrder& o = orders[k];
+            if (u < 0.75) {
+                putHeader(msg, (u<0.65)?'E':'X', locate, t); putU64(msg, o.ref); putU32(msg, 100);
+                if (msg[0] == 'E') putU64(msg, i);
+                o.size -= 100;
+            } else if (u < 0.9) {
+                putHeader(msg, 'D', locate, t); putU64(msg, o.ref);
+                o.size = 0;
+            } else {
+                putHeader(msg, 'U', locate, t); putU64(msg, o.ref); putU64(msg, ref);
+                o.ref = ref++;
+                o.size = 100*rng.uniformInt(1, 10);
+                putU32(msg, o.size); putU32(msg, price(o.bid, 20));
+            }
+            if (!o.size) {
+                orders[k] = orders.back();
+                orders.pop_back();
+            }
+        }
+        putMsg(f, msg);
+    }
+}
+
+void runItchReplay(string filename) {
+    ItchReplay itch(filename);
+    if (!itch.isOpen()) {
+        cout << "cannot open " << filename << endl;
+        return;
+    }
+    /**** throughput **********************************************************/
+    auto t1 = high_resolution_clock::now();
+    long long n = itch.replay();
+    auto t2 = high_resolution_clock::now();
+    auto t = duration_cast<nanoseconds>(t2-t1);
+    cout << "messages: " << n << " (" << itch.getNumApplied() << " applied), books: " << itch.getNumBooks()
+         << ", live orders: " << itch.getNumLiveOrders() << ", trades: " << itch.getNumTrades() << endl;
+    cout << "A " << itch.getCount('A') << ", F " << itch.getCount('F') << ", E " << itch.getCount('E') << ", C " << itch.getCount('C')
+         << ", X " << itch.getCount('X') << ", D " << itch.getCount('D') << ", U " << itch.getCount('U') << endl;
+    cout << "replay time per message: " << (double)t.count()/n << "ns, " << n/(t.count()/1e9)/1e6 << "M msgs/s, "
+         << itch.getFileSize()/(t.count()/1e9)/(1<<20) << "MB/s" << endl;
+    /**** latency *************************************************************/
+    // clock reads around every message, so the figures include their cost
+    itch.reset();
+    vector<int> latencies;
+    latencies.reserve(n);
+    while (true) {
+        auto t1 = steady_clock::now();
+        if (!itch.step()) break;
+        auto t2 = steady_clock::now();
+        latencies.push_back(duration_cast<nanoseconds>(t2-t1).count());
+    }
+    sort(latencies.begin(), latencies.end());
+    auto pct = [&](double p) {return latencies[min((size_t)(p*latencies.size()), latencies.size()-1)];};
+    if (latencies.size())
+        cout << "latency per message: p50 " << pct(0.5) << "ns, p90 " << pct(0.9) << "ns, p99 " << pct(0.99)
+             << "ns, p99.9 " << pct(0.999) << "ns, max " << latencies.back() << "ns" << endl;
+    for (int locate=1; locate<=min(3,(int)itch.getNumBooks()); locate++) {
+        LimitOrderBook* book = itch.getBookPtr(locate);
+        if (book) cout << itch.getBookName(locate) << ": bid " << book->getTopBid() << " x " << book->getBidDepthAt(book->getTopBid())
+                       << ", ask " << book->getTopAsk() << " x " << book->getAskDepthAt(book->getTopAsk()) << endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    // replays the ITCH 5.0 file given, or a generated sample
+    string filename = (argc>1)?argv[1]:"test/sample.itch";
+    if (argc <= 1) writeSampleItch(filename, 1<<20, 8);
+    runItchReplay(filename);
+    return 0;
+}
@@ -0,0 +1,80 @@
+#include <iostream>
+#include <chrono>
+#include "util.cpp"
+#include "side.hpp"
+#include "orderType.hpp"
+#include "orderBook.hpp"
+#include "marketDataFeed.hpp"
+using namespace std;
+using namespace chrono;
+
+vector<OrderMsg> makeNaiveMsgs(int n) {
+    int id = 0;
+    vector<OrderMsg> msgs;
+    msgs.reserve(n);
+    for (int i=0; i<n; i++) {
+        Side side    = (uniformRand()<0.5)?BID:ASK;
+        int size     = (int)uniformRand(5,20);
+        int ccl      = (int)uniformRand(0,id);
+        double u     = uniformRand();
+        double price = (int)((side==BID)?uniformRand(70,105):uniformRand(95,130));
+        if (u<0.6) msgs.push_back(OrderMsg(LIMIT,id++,i,0,side,size,price));
+        else if (u<0.8) msgs.push_back(OrderMsg(MARKET,id++,i,0,side,size));
+        else msgs.push_back(OrderMsg(CANCEL,id++,i,0,ccl));
+    }
+    return msgs;
+}
+
+void runFeed(const vector<OrderMsg>& msgs, int conflateEvents) {
+    // a consumer polls every 64 orders and must track the book exactly
+    LimitOrderBook ob;
+    MarketDataFeed feed(&ob, conflateEvents);
+    MarketDataBook consumer;
+    vector<LevelMsg> out;
+    long long numMsgs = 0;
+    bool same = true;
+    auto t1 = high_resolution_clock::now();
+    for (int i=0; i<(int)msgs.size(); i++) {
+        ob.setClock(i);
+        ob.processOrder(msgs[i]);
+        feed.publish();
+        if (i%64 == 63) {
+            numMsgs += feed.poll(out);
+            for (auto& msg : out) consumer.apply(msg);
+        }
+    }
+    feed.flush();
+    numMsgs += feed.poll(out);
+    for (auto& msg : out) consumer.apply(msg);
+    auto t2 = high_resolution_clock::now();
+    auto t = duration_cast<nanoseconds>(t2-t1);
+    same = !consumer.hasGap() && consumer.getBidDepths() == ob.getBidDepths() && consumer.getAskDepths() == ob.getAskDepths();
+    cout << "(conflation = " << conflateEvents << ") processing time per order: " << (float)t.count()/msgs.size() << "ns, "
+         << "messages per order: " << (double)numMsgs/msgs.size() << ", consumer book matches: " << ((same)?"yes":"no") << endl;
+}
+
+void runSnapshotJoin() {
+    // a consumer joining from a snapshot skips the messages it already holds
+    LimitOrderBook ob;
+    MarketDataFeed feed(&ob);
+    MarketDataBook consumer;
+    vector<LevelMsg> out;
+    ob.processOrder(OrderMsg(LIMIT,0,0,0,BID,10,99.0));
+    feed.publish();
+    ob.processOrder(OrderMsg(LIMIT,1,1,0,BID,10,98.0));
+    consumer.applySnapshot(feed.snapshot(), feed.getSeq());
+    ob.processOrder(OrderMsg(LIMIT,2,2,0,ASK,10,101.0));
+    feed.publish();
+    feed.poll(out);
+    for (auto& msg : out) consumer.apply(msg);
+    bool same = !consumer.hasGap() && consumer.getBidDepths() == ob.getBidDepths() && consumer.getAskDepths() == ob.getAskDepths();
+    cout << "(snapshot join) consumer book matches: " << ((same)?"yes":"no") << endl;
+}
+
+int main() {
+    seedRand(0);
+    vector<OrderMsg> msgs = makeNaiveMsgs(1<<20);
+    for (int w : {0, 16, 256}) runFeed(msgs, w);
+    runSnapshotJoin();
+    return 0;
+}
@@ -39,8 +39,40 @@ void runNaive(int n, bool showProcess=false, bool showFinalBook=false) {
     if (showFinalBook) ob.printBook(0,5);
 }
 
+vector<OrderMsg> makeNaiveMsgs(int n) {
+    int id = 0;
+    vector<OrderMsg> msgs;
+    msgs.reserve(n);
+    for (int i=0; i<n; i++) {
+        Side side    = (uniformRand()<0.5)?BID:ASK;
+        int size     = (int)uniformRand(5,20);
+        int ccl      = (int)uniformRand(0,id);
+        double u     = uniformRand();
+        double price = (int)((side==BID)?uniformRand(70,105):uniformRand(95,130));
+        if (u<0.6) msgs.push_back(OrderMsg(LIMIT,id++,0,0,side,size,price));
+        else if (u<0.8) msgs.push_back(OrderMsg(MARKET,id++,0,0,side,size));
+        else msgs.push_back(OrderMsg(CANCEL,id++,0,0,ccl));
+    }
+    return msgs;
+}
+
+void runBatch(int n, int batchSize) {
+    vector<OrderMsg> msgs = makeNaiveMsgs(n);
+    LimitOrderBook ob1, ob2;
+    auto t1 = high_resolution_clock::now();
+    for (auto& msg : msgs) ob1.processOrder(msg);
+    auto t2 = high_resolution_clock::now();
+    for (int i=0; i<n; i+=batchSize) ob2.processBatch(&msgs[i], min(batchSize,n-i));
+    auto t3 = high_resolution_clock::now();
+    auto t = duration_cast<nanoseconds>(t2-t1);
+    auto tb = duration_cast<nanoseconds>(t3-t2);
+    cout << "single processing time per order: " << (float)t.count()/n << "ns" << endl;
+    cout << "batch processing time per order: " << (float)tb.count()/n << "ns"
+         << " (batch size " << batchSize << ", " << n/(tb.count()/1e9)/1e6 << "M orders/s)" << endl;
+}
+
 int main() {
-    srand(0);
+    seedRand(0);
     /**** single runNaive *****************************************************/
     int n = 100;
     auto t1 = high_resolution_clock::now();
@@ -57,5 +89,7 @@ int main() {
     //     auto t = duration_cast<microseconds>(t2-t1);
     //     cout << "(m = " << m << ") processing time per order: " << (float)t.count()/n << "μs" << endl;
     // }
+    /**** batch test **********************************************************/
+    runBatch(1<<20,1024);
     return 0;
 }
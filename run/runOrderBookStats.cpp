@@ -1,11 +1,13 @@
 #include <iostream>
+#include <chrono>
 #include "util.cpp"
 #include "zeroIntelligence.hpp"
 #include "orderBookStats.hpp"
 using namespace std;
+using namespace chrono;
 
 int main() {
-    srand(0);
+    seedRand(0);
     /**** parameters **********************************************************/
     int n       = 1e4;
     int L       = 30;
@@ -24,9 +26,34 @@ int main() {
     vector<double> band; for (int b=-20; b<=20; b++) band.push_back(b);
     map<int,map<double,int>>* depthsB = zi.getBidDepthsLogPtr();
     map<int,map<double,int>>* depthsA = zi.getAskDepthsLogPtr();
-    deque<Trade*>* trades = zi.getTradesPtr();
+    vector<Trade>* trades = zi.getTradesPtr();
     OrderBookStats obs(*depthsB,*depthsA,*trades);
     obs.initStats();
+    /**** binary logs *********************************************************/
+    zi.printDepthsLogToBin("test/depths.bin");
+    zi.printTradesToBin("test/trades.bin");
+    auto t1 = high_resolution_clock::now();
+    OrderBookStats obsBin("test/depths.bin","test/trades.bin");
+    auto t2 = high_resolution_clock::now();
+    obsBin.loadDepthsLog();
+    obsBin.loadTrades();
+    obsBin.initStats();
+    auto t = duration_cast<microseconds>(t2-t1);
+    cout << "binary logs load time: " << t.count() << "μs, snapshots: " << obsBin.getDepthLogPtr()->getNumSnaps()
+         << ", stats match: " << ((obsBin.calcAvgBookDepths(band)==obs.calcAvgBookDepths(band))?"yes":"no") << endl;
+    /**** online stats ********************************************************/
+    ZeroIntelligence ziOnline(n,LL,L,lda,mu,nu,snpInt,snpLvl);
+    OrderBookStats obsOnline;
+    ziOnline.setOnlineStats(&obsOnline);
+    ziOnline.initOrderBook();
+    t1 = high_resolution_clock::now();
+    ziOnline.simulate();
+    t2 = high_resolution_clock::now();
+    t = duration_cast<microseconds>(t2-t1);
+    bool same = *obsOnline.getMidPricesPtr() == *obs.getMidPricesPtr() && *obsOnline.getMicroPricesPtr() == *obs.getMicroPricesPtr()
+        && *obsOnline.getImbalancesPtr() == *obs.getImbalancesPtr() && *obsOnline.getSpreadsPtr() == *obs.getSpreadsPtr();
+    cout << "online stats, processing time per order: " << (float)t.count()/n << "μs, depth snapshots kept: "
+         << ziOnline.getBidDepthsLogPtr()->size() << ", stats match: " << ((same)?"yes":"no") << endl;
     cout << obs.calcAvgBookDepths(band) << endl;
     return 0;
 }
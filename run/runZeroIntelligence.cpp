@@ -1,11 +1,30 @@
 #include <iostream>
 #include <chrono>
+#include "util.cpp"
 #include "zeroIntelligence.hpp"
 using namespace std;
 using namespace chrono;
 
+vector<OrderMsg> makeBranchMsgs(LimitOrderBook* ob, int n, int firstId, int numIds) {
+    // limit, market and cancel orders around the top of the book
+    vector<OrderMsg> msgs;
+    msgs.reserve(n);
+    for (int i=0; i<n; i++) {
+        int id       = firstId+i;
+        int time     = ob->getClock()+i;
+        Side side    = (uniformRand()<0.5)?BID:ASK;
+        int size     = uniformIntRand(1,10);
+        double u     = uniformRand();
+        double price = (side==BID)?ob->getTopBid()-uniformIntRand(-2,10):ob->getTopAsk()+uniformIntRand(-2,10);
+        if (u<0.6) msgs.push_back(OrderMsg(LIMIT,id,time,0,side,size,price));
+        else if (u<0.8) msgs.push_back(OrderMsg(MARKET,id,time,0,side,size));
+        else msgs.push_back(OrderMsg(CANCEL,id,time,0,uniformIntRand(0,numIds-1)));
+    }
+    return msgs;
+}
+
 int main() {
-    srand(0);
+    seedRand(0);
     /**** parameters **********************************************************/
     int n       = 1e4;
     int L       = 30;
@@ -17,16 +36,87 @@ int main() {
     double nu   = 0.2;
     string dataFolder = "test/";
     /**** ZI simulation *******************************************************/
+    // outputs are streamed to csv by a writer thread during the simulation
     ZeroIntelligence zi(n,LL,L,lda,mu,nu,snpInt,snpLvl);
+    if (!zi.streamToCsv(dataFolder+"trades.csv",dataFolder+"depths.csv")) {
+        cout << "cannot open " << dataFolder << "trades.csv or depths.csv" << endl;
+        return 1;
+    }
     zi.initOrderBook();
     auto t1 = high_resolution_clock::now();
     zi.simulate();
+    if (!zi.closeStream()) cout << "writing " << dataFolder << "trades.csv or depths.csv failed" << endl;
     auto t2 = high_resolution_clock::now();
     zi.printBook(30,10);
     auto t = duration_cast<microseconds>(t2-t1);
     cout << "processing time per order: " << (float)t.count()/n << "μs" << endl;
-    /**** outputs *************************************************************/
-    zi.printTradesToCsv(dataFolder+"trades.csv");
-    zi.printDepthsLogToCsv(dataFolder+"depths.csv");
+    /**** delta snapshots *****************************************************/
+    ZeroIntelligence ziFull(n,LL,L,lda,mu,nu,snpInt,snpLvl), ziDelta(ziFull);
+    ziDelta.setDeltaSnaps(true);
+    for (auto z : {&ziFull, &ziDelta}) {
+        z->initOrderBook();
+        auto t1 = high_resolution_clock::now();
+        z->simulate();
+        auto t2 = high_resolution_clock::now();
+        auto t = duration_cast<microseconds>(t2-t1);
+        cout << ((z==&ziFull)?"full":"delta") << " snapshots, processing time per order: " << (float)t.count()/n << "μs" << endl;
+    }
+    long long numLevels = 0;
+    for (auto& b : *ziFull.getBidDepthsLogPtr()) numLevels += b.second.size();
+    for (auto& a : *ziFull.getAskDepthsLogPtr()) numLevels += a.second.size();
+    ziDelta.rebuildDepthsLog();
+    bool same = *ziFull.getBidDepthsLogPtr() == *ziDelta.getBidDepthsLogPtr() && *ziFull.getAskDepthsLogPtr() == *ziDelta.getAskDepthsLogPtr();
+    cout << "levels logged: " << numLevels << " full, " << ziDelta.getDepthJournalPtr()->getNumEntries() << " delta, "
+         << "rebuilt snapshots match: " << ((same)?"yes":"no") << endl;
+    /**** checkpoint **********************************************************/
+    // a run saved halfway and resumed from the file ends as the full run
+    ZeroIntelligence ziHalf(n/2,LL,L,lda,mu,nu,snpInt,snpLvl), ziResumed;
+    ziHalf.initOrderBook();
+    ziHalf.simulate();
+    ziHalf.saveCheckpoint(dataFolder+"zi.ckpt");
+    t1 = high_resolution_clock::now();
+    ziResumed.loadCheckpoint(dataFolder+"zi.ckpt");
+    t2 = high_resolution_clock::now();
+    ziResumed.setNumOrder(n);
+    ziResumed.simulate();
+    same = *ziFull.getBidDepthsLogPtr() == *ziResumed.getBidDepthsLogPtr() && *ziFull.getAskDepthsLogPtr() == *ziResumed.getAskDepthsLogPtr()
+        && ziFull.getLimitOrderBookPtr()->getAsJson() == ziResumed.getLimitOrderBookPtr()->getAsJson();
+    cout << "checkpoint load time: " << (float)duration_cast<microseconds>(t2-t1).count()/1000 << "ms, "
+         << "resumed run matches: " << ((same)?"yes":"no") << endl;
+    /**** forks ***************************************************************/
+    // what-if branches of one book, each applying its own orders, as forks
+    // sharing the untouched levels of the book and as full copies
+    int numBranches = 1000, branchSize = 20;
+    LimitOrderBook* ob = ziFull.getLimitOrderBookPtr();
+    vector<vector<OrderMsg>> branchMsgs(numBranches);
+    for (auto& msgs : branchMsgs) msgs = makeBranchMsgs(ob,branchSize,n,n);
+    vector<LimitOrderBook*> forks(numBranches), copies(numBranches);
+    t1 = high_resolution_clock::now();
+    for (int k=0; k<numBranches; k++) {
+        forks[k] = ob->fork();
+        for (auto& msg : branchMsgs[k]) forks[k]->processOrder(msg);
+    }
+    t2 = high_resolution_clock::now();
+    for (int k=0; k<numBranches; k++) {
+        copies[k] = ob->copy();
+        for (auto& msg : branchMsgs[k]) copies[k]->processOrder(msg);
+    }
+    auto t3 = high_resolution_clock::now();
+    long long forkNodes = 0, copyNodes = 0;
+    same = true;
+    for (int k=0; k<numBranches; k++) {
+        forkNodes += forks[k]->getNodePoolPtr()->getNumAllocated();
+        copyNodes += copies[k]->getNodePoolPtr()->getNumAllocated();
+        vector<Trade>* trades = copies[k]->getTradesPtr();
+        same = same && forks[k]->getAsJson() == copies[k]->getAsJson()
+            && forks[k]->getTradesPtr()->size() == trades->size()-ob->getTradesPtr()->size();
+        delete forks[k];
+        delete copies[k];
+    }
+    cout << numBranches << " branches of " << branchSize << " orders, time per branch: "
+         << (float)duration_cast<microseconds>(t2-t1).count()/numBranches << "μs forked, "
+         << (float)duration_cast<microseconds>(t3-t2).count()/numBranches << "μs copied" << endl;
+    cout << "order nodes per branch: " << (float)forkNodes/numBranches << " forked, " << (float)copyNodes/numBranches << " copied, "
+         << "forks match copies: " << ((same)?"yes":"no") << endl;
     return 0;
 }
@@ -0,0 +1,41 @@
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include "util.cpp"
+#include "zeroIntelligence.hpp"
+#include "zeroIntelligenceEnsemble.hpp"
+#include "orderBookStats.hpp"
+using namespace std;
+using namespace chrono;
+
+int main() {
+    /**** parameters **********************************************************/
+    int n       = 1e4;
+    int L       = 30;
+    int LL      = 1000;
+    int snpInt  = 10;
+    int snpLvl  = 40;
+    double lda  = 1;
+    double mu   = 50;
+    double nu   = 0.2;
+    int numSim  = 16;
+    /**** ZI ensemble *********************************************************/
+    ZeroIntelligence zi(n,LL,L,lda,mu,nu,snpInt,snpLvl);
+    vector<double> band; for (int b=-20; b<=20; b++) band.push_back(b);
+    map<double,double> avgBookDepths;
+    vector<int> threads{1};
+    if (thread::hardware_concurrency() > 1) threads.push_back(thread::hardware_concurrency());
+    for (int numThreads : threads) {
+        ZeroIntelligenceEnsemble ensemble(zi,numSim,0,numThreads);
+        auto t1 = high_resolution_clock::now();
+        ensemble.simulate();
+        auto t2 = high_resolution_clock::now();
+        auto t = duration_cast<microseconds>(t2-t1);
+        map<double,double> depths = ensemble.getStatsPtr()->calcAvgBookDepths(band);
+        cout << "(threads = " << numThreads << ") processing time per simulation: " << (float)t.count()/numSim/1e3 << "ms"
+             << ((numThreads>1)?((depths==avgBookDepths)?", same as 1 thread":", differs from 1 thread"):"") << endl;
+        avgBookDepths = depths;
+    }
+    cout << avgBookDepths << endl;
+    return 0;
+}